@@ -0,0 +1,246 @@
+//
+//  Aggregator.cpp
+//
+//  Created by Yunhsiu Wu on 5/26/21.
+//
+
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <functional>
+#include "Aggregator.hpp"
+#include "Sorter.hpp"
+
+namespace ECE141 {
+
+    //number of files the overflow rows are spread over
+    const size_t kPartitionCount = 16;
+    //deeper passes keep everything in memory
+    const size_t kMaxLevel = 4;
+    //rough overhead of a group beyond its keys and values
+    const size_t kGroupOverhead = 128;
+
+    HashAggregator::HashAggregator(const StringList& aGroupBy, const AggregateList& anAggregates,
+        const StringList& aCarried, size_t aMemory, size_t aLevel)
+        : groupBy(aGroupBy), aggregates(anAggregates), carried(aCarried),
+        memory(aMemory), level(aLevel), used(0) {}
+
+    HashAggregator::~HashAggregator() {
+        for (auto& partition : partitions) {
+            partition.output.reset();
+            std::remove(partition.path.c_str());
+        }
+    }
+
+    //helper: numeric value of bool, int or double, false for strings
+    static bool toNumber(const Value& aValue, double& aNumber) {
+        switch (aValue.index()) {
+        case 0: aNumber = std::get<bool>(aValue) ? 1.0 : 0.0; return true;
+        case 1: aNumber = std::get<int>(aValue); return true;
+        case 2: aNumber = std::get<double>(aValue); return true;
+        default: return false;
+        }
+    }
+
+    void HashAggregator::fold(Group& aGroup, Row& aRow) {
+        KeyValues& theData = aRow.getData();
+
+        for (size_t i = 0; i < aggregates.size(); ++i) {
+            const Aggregate& theAggregate = aggregates[i];
+            State& theState = aGroup.states[i];
+
+            if (theAggregate.field == "*") {
+                ++theState.count;
+                continue;
+            }
+
+            auto theValue = theData.find(theAggregate.field);
+            if (theValue == theData.end())
+                continue; //missing values are ignored like SQL NULLs
+
+            double theNumber = 0;
+            switch (theAggregate.function) {
+            case Keywords::sum_kw:
+            case Keywords::avg_kw:
+                if (!toNumber(theValue->second, theNumber))
+                    continue;
+                theState.sum += theNumber;
+                theState.isInteger = theState.isInteger && theValue->second.index() != 2;
+                break;
+
+            case Keywords::min_kw:
+            case Keywords::max_kw: {
+                std::string theKey;
+                SortKey::append(theKey, &theValue->second);
+                bool isMin = theAggregate.function == Keywords::min_kw;
+                if (!theState.count || (isMin ? theKey < theState.key : theKey > theState.key)) {
+                    theState.key = theKey;
+                    theState.value = theValue->second;
+                }
+                break;
+            }
+
+            default:
+                break;
+            }
+            ++theState.count;
+        }
+    }
+
+    Value HashAggregator::finish(const Aggregate& anAggregate, State& aState) {
+        if (anAggregate.function == Keywords::count_kw)
+            return int(aState.count);
+
+        if (!aState.count)
+            return std::string("NULL");
+
+        switch (anAggregate.function) {
+        case Keywords::sum_kw:
+            if (aState.isInteger && aState.sum >= std::numeric_limits<int>::min()
+                && aState.sum <= std::numeric_limits<int>::max())
+                return int(aState.sum);
+            return aState.sum;
+
+        case Keywords::avg_kw:
+            return aState.sum / aState.count;
+
+        default:
+            return aState.value;
+        }
+    }
+
+    StatusResult HashAggregator::spill(const std::string& aKey, Row& aRow) {
+        if (partitions.empty()) {
+            for (size_t i = 0; i < kPartitionCount; ++i) {
+                Partition thePartition{ Config::getTempPath("aggpart"), nullptr };
+                thePartition.output = std::make_unique<std::ofstream>(thePartition.path,
+                    std::ios::binary | std::ios::trunc);
+                if (!*thePartition.output)
+                    return StatusResult{ Errors::writeError };
+                partitions.push_back(std::move(thePartition));
+            }
+        }
+
+        //a different hash on every level so a partition splits up again
+        size_t theHash = std::hash<std::string>{}(std::to_string(level) + aKey);
+        std::ofstream& theOutput = *partitions[theHash % kPartitionCount].output;
+
+        std::stringstream ss;
+        aRow.encode(ss);
+        std::string theRow = ss.str();
+        uint32_t theSize = uint32_t(theRow.size());
+        theOutput.write((char*)&theSize, sizeof(theSize));
+        theOutput.write(theRow.data(), theSize);
+
+        return theOutput ? StatusResult{ Errors::noError } : StatusResult{ Errors::writeError };
+    }
+
+    StatusResult HashAggregator::add(std::unique_ptr<Row> aRow) {
+        KeyValues& theData = aRow->getData();
+
+        std::string theKey;
+        for (auto& field : groupBy) {
+            auto theValue = theData.find(field);
+            SortKey::append(theKey, theValue == theData.end() ? nullptr : &theValue->second);
+        }
+
+        auto theGroup = lookup.find(theKey);
+        if (theGroup != lookup.end()) {
+            fold(groups[theGroup->second], *aRow);
+            return StatusResult{ Errors::noError };
+        }
+
+        //no room for another group, leave the row for a later pass
+        if (used > memory && level < kMaxLevel)
+            return spill(theKey, *aRow);
+
+        Group theNew;
+        theNew.states.resize(aggregates.size());
+        used += kGroupOverhead + 2 * theKey.size() + aggregates.size() * sizeof(State);
+        for (auto* theFields : { &groupBy, &carried }) {
+            for (auto& field : *theFields) {
+                auto theValue = theData.find(field);
+                if (theValue != theData.end()) {
+                    theNew.fields[field] = theValue->second;
+                    used += field.size() + sizeof(Value) + 48;
+                }
+            }
+        }
+
+        fold(theNew, *aRow);
+        lookup[theKey] = groups.size();
+        groups.push_back(std::move(theNew));
+        return StatusResult{ Errors::noError };
+    }
+
+    StatusResult HashAggregator::each(const RowVisitor& aVisitor) {
+        //aggregates without group by always produce one row
+        if (groups.empty() && groupBy.empty() && !level) {
+            groups.push_back(Group());
+            groups.back().states.resize(aggregates.size());
+        }
+
+        for (auto& group : groups) {
+            KeyValues theData = group.fields;
+            for (size_t i = 0; i < aggregates.size(); ++i)
+                theData[aggregates[i].name] = finish(aggregates[i], group.states[i]);
+            if (!aVisitor(std::make_unique<Row>(theData, 0)))
+                return StatusResult{ Errors::noError };
+        }
+        groups.clear();
+        lookup.clear();
+
+        //aggregate each overflow partition on its own
+        for (auto& partition : partitions) {
+            partition.output.reset();
+
+            HashAggregator thePass(groupBy, aggregates, carried, memory, level + 1);
+            std::ifstream theInput(partition.path, std::ios::binary);
+            uint32_t theSize = 0;
+            std::string theRow;
+            while (theInput.read((char*)&theSize, sizeof(theSize))) {
+                theRow.resize(theSize);
+                theInput.read(&theRow[0], theSize);
+
+                std::stringstream ss(theRow);
+                std::unique_ptr<Row> row = std::make_unique<Row>();
+                row->decode(ss);
+                StatusResult theResult = thePass.add(std::move(row));
+                if (!theResult)
+                    return theResult;
+            }
+            theInput.close();
+            std::remove(partition.path.c_str());
+
+            bool keepGoing = true;
+            StatusResult theResult = thePass.each([&](std::unique_ptr<Row> aRow) {
+                return keepGoing = aVisitor(std::move(aRow));
+                });
+            if (!theResult || !keepGoing)
+                return theResult;
+        }
+        partitions.clear();
+
+        return StatusResult{ Errors::noError };
+    }
+
+    bool DistinctFilter::isNew(Row& aRow) {
+        KeyValues& theData = aRow.getData();
+        std::string theKey;
+        for (auto& field : fields) {
+            auto theValue = theData.find(field);
+            SortKey::append(theKey, theValue == theData.end() ? nullptr : &theValue->second);
+        }
+
+        if (ordered) {
+            if (hasLast && theKey == last)
+                return false;
+            last.swap(theKey);
+            hasLast = true;
+            return true;
+        }
+
+        return seen.insert(std::move(theKey)).second;
+    }
+
+}
@@ -0,0 +1,104 @@
+//
+//  Aggregator.hpp
+//
+//  Created by Yunhsiu Wu on 5/26/21.
+//
+
+#ifndef Aggregator_hpp
+#define Aggregator_hpp
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include "BasicTypes.hpp"
+#include "keywords.hpp"
+#include "Errors.hpp"
+#include "Row.hpp"
+#include "Config.hpp"
+
+namespace ECE141 {
+
+    //one aggregate in a select list, e.g. count(*) or sum(zipcode)
+    struct Aggregate {
+        Keywords    function; //count_kw, sum_kw, avg_kw, min_kw or max_kw
+        std::string field;    //"*" for count(*)
+        std::string name;     //output column
+    };
+
+    using AggregateList = std::vector<Aggregate>;
+
+    //groups rows on the group by fields in a hash table and folds each
+    //group into its aggregates; once the groups outgrow the memory budget,
+    //rows of new groups are hash partitioned to disk and aggregated later
+    class HashAggregator {
+    public:
+        HashAggregator(const StringList& aGroupBy, const AggregateList& anAggregates,
+            const StringList& aCarried, size_t aMemory = Config::getSortMemory(), size_t aLevel = 0);
+        ~HashAggregator();
+
+        StatusResult add(std::unique_ptr<Row> aRow);
+
+        //emit one row per group: group and carried fields plus the aggregates
+        StatusResult each(const RowVisitor& aVisitor);
+
+        size_t getPartitionCount() const { return partitions.size(); }
+
+    protected:
+        struct State {
+            size_t      count = 0;
+            double      sum = 0;
+            bool        isInteger = true; //sum of ints only
+            Value       value;            //current min or max
+            std::string key;              //normalized key of value
+        };
+
+        struct Group {
+            KeyValues          fields; //group and carried fields of the first row
+            std::vector<State> states;
+        };
+
+        struct Partition {
+            std::string                    path;
+            std::unique_ptr<std::ofstream> output;
+        };
+
+        void         fold(Group& aGroup, Row& aRow);
+        Value        finish(const Aggregate& anAggregate, State& aState);
+        StatusResult spill(const std::string& aKey, Row& aRow);
+
+        StringList    groupBy;
+        AggregateList aggregates;
+        StringList    carried; //plain selected fields outside the group by
+        size_t        memory;
+        size_t        level;   //recursion depth of partition passes
+        size_t        used;
+
+        std::unordered_map<std::string, size_t> lookup; //group key -> groups
+        std::vector<Group>                      groups; //in first seen order
+        std::vector<Partition>                  partitions;
+    };
+
+    //drops rows whose values in the given fields were seen before; when the
+    //rows arrive ordered on those fields only the previous key is kept
+    class DistinctFilter {
+    public:
+        DistinctFilter(const StringList& aFields, bool anOrdered = false)
+            : fields(aFields), ordered(anOrdered), hasLast(false) {}
+
+        //true the first time a combination of values shows up
+        bool isNew(Row& aRow);
+
+    protected:
+        StringList                      fields;
+        bool                            ordered;
+        std::unordered_set<std::string> seen;
+        std::string                     last;
+        bool                            hasLast;
+    };
+
+}
+
+#endif /* Aggregator_hpp */
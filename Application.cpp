@@ -9,6 +9,7 @@
 #include <iostream>
 #include "Application.hpp"
 #include "Tokenizer.hpp"
+#include "Config.hpp"
 #include <memory>
 #include <vector>
 #include <algorithm>
@@ -17,7 +18,7 @@
 namespace ECE141 {
   
     Application::Application(std::ostream& anOutput)
-        : CmdProcessor(anOutput), theDBProc(anOutput) {
+        : CmdProcessor(anOutput), theScheduler(Config::getWorkerCount()), theDBProc(anOutput, theScheduler) {
     }
   
     Application::~Application() {
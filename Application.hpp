@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include "CmdProcessor.hpp"
 #include "DBProcessor.hpp"
+#include "Scheduler.hpp"
 
 namespace ECE141 {
 
@@ -27,6 +28,7 @@ namespace ECE141 {
     StatusResult  run(Statement *aStmt, const Timer& aTimer) override;
     
   protected:
+      Scheduler   theScheduler; //workers shared by every query, outlives the databases
       DBProcessor theDBProc;
   };
   
@@ -12,18 +12,18 @@ namespace ECE141 {
 
     Attribute::Attribute()
         :name(""), type(DataTypes{ 'N' }), length(0), nullable(false),
-        auto_increment(false), primary_key(false), hasDefault(false), default_value(0) {}
+        auto_increment(false), primary_key(false), hasDefault(false), default_value(0), version(0) {}
 
     Attribute::Attribute(std::string aName, DataTypes aType, int aLength, bool aNullable, 
         bool anAutoIncrement, bool aPrimaryKey, bool aHasDefault, Value aDefault)
         : name(aName), type(aType), length(aLength), nullable(aNullable),
         auto_increment(anAutoIncrement), primary_key(aPrimaryKey), 
-        hasDefault(aHasDefault), default_value(aDefault) {}
+        hasDefault(aHasDefault), default_value(aDefault), version(0) {}
 
     Attribute::Attribute(const Attribute& aCopy)
         : name(aCopy.name), type(aCopy.type), length(aCopy.length), nullable(aCopy.nullable),
         auto_increment(aCopy.auto_increment), primary_key(aCopy.primary_key),
-        hasDefault(aCopy.hasDefault), default_value(aCopy.default_value) {}
+        hasDefault(aCopy.hasDefault), default_value(aCopy.default_value), version(aCopy.version) {}
 
     Attribute& Attribute::operator=(const Attribute& aCopy) {
         name           = aCopy.name;
@@ -33,6 +33,7 @@ namespace ECE141 {
         primary_key    = aCopy.primary_key;
         hasDefault     = aCopy.hasDefault;
         default_value  = aCopy.default_value;
+        version        = aCopy.version;
 
         return *this;
     }
@@ -28,6 +28,7 @@ namespace ECE141 {
     bool        nullable;
     bool        hasDefault;
     Value       default_value;
+    uint32_t    version;    //schema version of the table that added it
     
   public:
       Attribute();
@@ -55,6 +56,7 @@ namespace ECE141 {
       void setNullable(bool aNullable) { nullable = aNullable; }
       void setHasDefault(bool aHasDefault) { hasDefault = aHasDefault; }
       void setDefaultValue(Value aDefault) { default_value = aDefault; }
+      void setVersion(uint32_t aVersion) { version = aVersion; }
     
       //access data
       std::string getName()         { return name; }
@@ -65,6 +67,7 @@ namespace ECE141 {
       bool        isNullable()      { return nullable; }
       bool        hasDefaultValue() { return hasDefault; }
       Value       getDefaultValue() { return default_value; }
+      uint32_t    getVersion()      { return version; }
 
       /*----------------Storable----------------*/
       StatusResult encode(std::ostream& aWriter) override;
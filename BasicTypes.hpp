@@ -9,6 +9,7 @@
 #define BasicTypes_h
 
 #include <map>
+#include <set>
 #include <vector>
 #include <string>
 #include <variant>
@@ -26,6 +27,7 @@ namespace ECE141 {
 
   using NamedIndex = std::map<std::string, uint32_t>;
   using StringList = std::vector<std::string>;
+  using StringSet  = std::set<std::string>;
   using StringMap = std::map<std::string, std::string>;
   using StringOpt = std::optional<std::string>;
   using IntOpt    = std::optional<uint32_t>;
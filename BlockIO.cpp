@@ -5,6 +5,7 @@
 //  Created by rick gessner on 2/27/21.
 //
 
+#include <atomic>
 #include "BlockIO.hpp"
 
 namespace ECE141 {
@@ -52,9 +53,24 @@ namespace ECE141 {
     return write(aBlock, stream, theSize);
   }
 
+  // USE: write a run of blocks starting at a given block ---------------------------
+  StatusResult BlockIO::writeBlocks(uint32_t aBlockNum, Block *aBlocks, size_t aCount) {
+    static size_t theSize=sizeof(Block);
+    stream.seekg(stream.tellg(), std::ios::beg); //sync buffers...
+    stream.seekp(aBlockNum * theSize);
+    return write(*aBlocks, stream, theSize * aCount);
+  }
+
   // USE: write data a given block (after seek) ---------------------------------------
+  static std::atomic<size_t> gReadCount{0};
+
+  size_t BlockIO::getReadCount() {
+    return gReadCount;
+  }
+
   StatusResult BlockIO::readBlock(uint32_t aBlockNumber, Block &aBlock) {
     static size_t theSize=sizeof(aBlock);
+    gReadCount.fetch_add(1, std::memory_order_relaxed);
     stream.seekg(aBlockNumber * theSize);
     //size_t thePos=stream.tellg();
     if(!stream.read ((char*)&aBlock, theSize)) {
@@ -63,6 +79,17 @@ namespace ECE141 {
     return StatusResult{noError};
   }
 
+  // USE: read a run of blocks starting at a given block ---------------------------
+  StatusResult BlockIO::readBlocks(uint32_t aBlockNumber, Block *aBlocks, size_t aCount) {
+    static size_t theSize=sizeof(Block);
+    gReadCount.fetch_add(aCount, std::memory_order_relaxed);
+    stream.seekg(aBlockNumber * theSize);
+    if(!stream.read ((char*)aBlocks, theSize * aCount)) {
+      return StatusResult(readError);
+    }
+    return StatusResult{noError};
+  }
+
   // USE: count blocks in file ---------------------------------------
   uint32_t BlockIO::getBlockCount() {
     stream.seekg(stream.tellg(), std::ios::beg); //force read mode; dumb c++ issue...
@@ -20,6 +20,7 @@ namespace ECE141 {
     entity_block='E',
     free_block='F',
     index_block='I',
+    stats_block='S',
     unknown_block='U',
   };
 
@@ -86,6 +87,15 @@ namespace ECE141 {
                                     Block &aBlock);
     virtual StatusResult  writeBlock(uint32_t aBlockNumber,
                                      Block &aBlock);
+    //write aCount consecutive blocks with one seek and one flush
+    StatusResult          writeBlocks(uint32_t aBlockNumber,
+                                      Block *aBlocks, size_t aCount);
+    //read aCount consecutive blocks with one seek
+    StatusResult          readBlocks(uint32_t aBlockNumber,
+                                     Block *aBlocks, size_t aCount);
+
+    //blocks read by every BlockIO so far (EXPLAIN ANALYZE)
+    static size_t         getReadCount();
     
   protected:
     std::iostream &stream;
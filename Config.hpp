@@ -8,6 +8,11 @@
 #ifndef Config_h
 #define Config_h
 #include <sstream>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 //#include <filesystem>
 
 struct Config {
@@ -34,6 +39,56 @@ struct Config {
     theStream << Config::getStoragePath() << "/" << aDBName << ".db";
     return theStream.str();
   }
+
+  //unique path for a scratch file (sort runs, spilled partitions...)
+  static std::string getTempPath(const std::string &aPrefix) {
+    static std::atomic<uint32_t> theCounter{0};
+    std::ostringstream theStream;
+    theStream << Config::getStoragePath() << "/" << aPrefix << "_"
+      << std::chrono::steady_clock::now().time_since_epoch().count()
+      << "_" << theCounter++ << ".tmp";
+    return theStream.str();
+  }
+
+  //bytes an operator may hold in memory before it spills to disk
+  static size_t getSortMemory() {return sortMemory();}
+  static void   setSortMemory(size_t aBytes) {sortMemory()=aBytes;}
+
+  //threads of the shared scheduler
+  static size_t getWorkerCount() {return std::max(std::thread::hardware_concurrency(), 1u);}
+
+  //scheduler workers one query may keep busy, 1 runs it on the calling thread
+  static size_t getParallelism() {return parallelism();}
+  static void   setParallelism(size_t aCount) {parallelism()=aCount ? aCount : 1;}
+
+  //bytes of a data file LOAD DATA reads and parses as one piece
+  static size_t getLoadChunkSize() {return loadChunkSize();}
+  static void   setLoadChunkSize(size_t aBytes) {loadChunkSize()=aBytes ? aBytes : 1;}
+
+  //bytes COPY TO collects before each write to its file
+  static size_t getExportBufferSize() {return exportBufferSize();}
+  static void   setExportBufferSize(size_t aBytes) {exportBufferSize()=aBytes ? aBytes : 1;}
+
+protected:
+  static size_t& sortMemory() {
+    static size_t theBytes=64*1024*1024;
+    return theBytes;
+  }
+
+  static size_t& loadChunkSize() {
+    static size_t theBytes=1024*1024;
+    return theBytes;
+  }
+
+  static size_t& exportBufferSize() {
+    static size_t theBytes=4*1024*1024;
+    return theBytes;
+  }
+
+  static size_t& parallelism() {
+    static size_t theCount=getWorkerCount();
+    return theCount;
+  }
   
 };
 
@@ -23,8 +23,8 @@
 
 namespace ECE141 {
 
-    DBProcessor::DBProcessor(std::ostream& anOutput)
-        : CmdProcessor(anOutput), theDB(nullptr), theSQLProc(anOutput) {}
+    DBProcessor::DBProcessor(std::ostream& anOutput, Scheduler& aScheduler)
+        : CmdProcessor(anOutput), theDB(nullptr), theSQLProc(anOutput), scheduler(aScheduler) {}
 
     DBProcessor::~DBProcessor() {
         if(theDB)
@@ -154,6 +154,7 @@ namespace ECE141 {
         //allocate a new database and tell SQL processor to change database        
         if (!theDB) {
             theDB = new Database(dbName, OpenDB());
+            theDB->setScheduler(&scheduler);
             theSQLProc.changeDatabase(theDB);
         }
         
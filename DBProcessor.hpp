@@ -12,13 +12,14 @@
 #include "CmdProcessor.hpp"
 #include "Database.hpp"
 #include "SQLProcessor.hpp"
+#include "Scheduler.hpp"
 
 namespace ECE141 {
 
     class DBProcessor : public CmdProcessor {
     public:
 
-        DBProcessor(std::ostream& anOutput);
+        DBProcessor(std::ostream& anOutput, Scheduler& aScheduler);
         virtual ~DBProcessor();
 
         StatusResult createDB(Statement* aStatement);
@@ -34,6 +35,7 @@ namespace ECE141 {
     protected:
         Database *theDB;
         SQLProcessor theSQLProc;
+        Scheduler& scheduler; //owned by the application
     };
 
 }
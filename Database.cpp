@@ -8,21 +8,59 @@
 #include <string>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <limits>
 #include <sstream>
 #include <map>
 #include <memory>
 #include <vector>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cmath>
+#include <cctype>
+#include <tuple>
+#include <filesystem>
 #include "BasicTypes.hpp"
 #include "Storage.hpp"
 #include "Database.hpp"
 #include "Config.hpp"
 #include "BlockIO.hpp"
 #include "Row.hpp"
+#include "Sorter.hpp"
+#include "Joiner.hpp"
+#include "Aggregator.hpp"
 
 namespace ECE141 {
+
+  //decode a row from its first block, reading the blocks chained to it
+  //when the row is longer than one; a row written under an older schema of
+  //anEntity comes out in the current one. aChain, when given, collects the
+  //numbers of the chained blocks read
+  static std::unique_ptr<Row> decodeRow(BlockIO& anIO, const Block& aBlock, const StringSet* aProjection,
+      Entity& anEntity, std::vector<uint32_t>* aChain = nullptr) {
+      std::stringstream ss;
+      ss.write(aBlock.payload, aBlock.header.size);
+      Block theBlock;
+      uint32_t theNext = aBlock.header.next;
+      for (size_t pos = 1; theNext && pos < aBlock.header.count && anIO.readBlock(theNext, theBlock); ++pos) {
+          if (aChain)
+              aChain->push_back(theNext);
+          ss.write(theBlock.payload, theBlock.header.size);
+          theNext = theBlock.header.next;
+      }
+      std::unique_ptr<Row> row = std::make_unique<Row>();
+      row->decode(ss, aProjection);
+      if (row->getVersion() < anEntity.getVersion()) {
+          anEntity.upgrade(row->getData(), row->getVersion(), aProjection);
+          row->setVersion(anEntity.getVersion());
+      }
+      return row;
+  }
   
   Database::Database(const std::string aName, CreateDB)
-    : name(aName), storage(stream), changed(true)  {
+    : name(aName), storage(stream), changed(true), scheduler(nullptr), plan(nullptr)  {
       std::string thePath = Config::getDBPath(name);
       stream.clear(); // Clear Flag, then create file...
       stream.open(thePath.c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
@@ -38,7 +76,7 @@ namespace ECE141 {
   }
 
   Database::Database(const std::string aName, OpenDB)
-    : name(aName), changed(false), storage(stream) {
+    : name(aName), changed(false), storage(stream), scheduler(nullptr), plan(nullptr) {
       
       std::string thePath = Config::getDBPath(name);
       stream.open (thePath.c_str(), std::fstream::binary | std::fstream::in | std::fstream::out);
@@ -67,6 +105,24 @@ namespace ECE141 {
           indexes.push_back(theIndex);
       }
 
+      //statistics of analyzed tables
+      for (auto& entity : entities) {
+          if (!entity.getStatsBlock())
+              continue;
+          std::stringstream ss2;
+          storage.load(ss2, entity.getStatsBlock());
+          TableStats theStats;
+          if (theStats.decode(ss2))
+              statistics[entity.getName()] = theStats;
+      }
+
+      //tables saved without a row count take it from their primary key index
+      for (auto& entity : entities) {
+          Attribute* theKey = entity.getPrimaryKey();
+          Index* theIndex = theKey ? findIndex(entity.getName(), theKey->getName()) : nullptr;
+          if (!entity.hasRowCount())
+              entity.setRowCount(theIndex ? uint32_t(theIndex->getSize()) : 0);
+      }
   }
 
   Database::~Database() {
@@ -144,18 +200,12 @@ namespace ECE141 {
       return res;
   }
 
-  void Database::deleteIndexes(KeyValues& aKeyValue) {
+  Index* Database::findIndex(const std::string& aTableName, const std::string& aFieldName) {
       for (auto& index : indexes) {
-          std::string theField = index.getFieldName();
-          if (index.getType() == IndexType::intKey) {
-              uint32_t theKey = std::get<int>(aKeyValue[theField]);
-              index.erase(theKey);
-          }
-          else {
-              std::string theKey = std::get<std::string>(aKeyValue[theField]);
-              index.erase(theKey);
-          }
+          if (index.getTableName() == aTableName && index.getFieldName() == aFieldName)
+              return &index;
       }
+      return nullptr;
   }
 
   void Database::deleteAllIndexes(std::string aTableName) {
@@ -174,22 +224,6 @@ namespace ECE141 {
       indexes = newIndexes;
   }
   
-  void Database::insertIndexes(std::vector<Index*> anIndexes, KeyValues& aKeyValue, uint32_t blockNum) {
-      for (auto* index : anIndexes) {
-          std::string theField = index->getFieldName();
-          if (index->getType() == IndexType::intKey) {
-              uint32_t theKey = std::get<int>(aKeyValue[theField]);
-              Index::ValueProxy theProxy = (*index)[theKey];
-              theProxy = blockNum;
-          }
-          else {
-              std::string theKey = std::get<std::string> (aKeyValue[theField]);
-              Index::ValueProxy theProxy = (*index)[theKey];
-              theProxy = blockNum;
-          }
-      }
-  }
-   
   StatusResult Database::addTable(std::string aName, const std::vector<Attribute>& anAttributes) {
       if (tables.count(aName))
           return StatusResult{ Errors::tableExists };
@@ -233,95 +267,79 @@ namespace ECE141 {
   }
 
   StatusResult Database::dropTable(std::string aName) {
-      if (!tables.count(aName))
-          return StatusResult{ Errors::unknownTable };
+      StatusResult result = truncateTable(aName);
+      if (!result)
+          return result;
 
-      uint32_t count = 0;
-      uint32_t blockNum = tables[aName];
-      //remove from table map
+      //the indexes and the entity go with the rows
+      deleteAllIndexes(aName);
+      storage.markBlockAsFree(tables[aName]);
       tables.erase(aName);
-
-      //erase from table list
       for (size_t i = 0; i < entities.size(); ++i) {
           if (entities[i].getName() == aName) {
-              //set up a query with no filter
-              std::shared_ptr<Query> theQuery = std::make_unique<Query>();
-              theQuery->setFrom(&entities[i]);
-
-              //delete all rows
-              StatusResult result = deleteRows(theQuery);
-              
-              //delete all the associated indexes
-              deleteAllIndexes(entities[i].getName());
-
-              if (!result)
-                  return result;
-              else
-                  count += result.value;
-
-              //remove from entity list
               entities.erase(entities.begin() + i);
-
               break;
           }
       }
 
-      storage.markBlockAsFree(blockNum);
       changed = true;
-      return StatusResult{ Errors::noError, count };
+      return result;
   }
 
-  StatusResult Database::alterRow(Attribute& anAtt, Keywords aMode, std::string aTableName, std::string aPrimaryKey) {
-      for (auto& index : indexes) {
-          if (index.getTableName() == aTableName && index.getFieldName() == aPrimaryKey) {
-              index.each([&](const Block& theBlock, uint32_t blockIndex)->bool {
-                  //read and decode row data
-                  std::stringstream ss;
-                  ss.write(theBlock.payload, theBlock.header.size);
-                  Row row;
-                  row.decode(ss);
-
-                  //update and encode
-                  std::stringstream news; //a new stream
-                  if (aMode == Keywords::add_kw)
-                      row.addData(anAtt.getName(), std::string(""));
-                  else
-                      row.dropData(anAtt.getName());
-
-                  row.encode(news);
-
-                  //prepare for a new block
-                  Block newBlock = theBlock;
-                  newBlock.header.size = news.str().size();
-                  news.read(newBlock.payload, newBlock.header.size);
-
-                  //overwrite data
-                  storage.writeBlock(blockIndex, newBlock);
-                  return true;
-                  }
-              );
-              break;
+  StatusResult Database::truncateTable(std::string aName) {
+      Entity* theEntity = getEntity(aName);
+      if (!theEntity)
+          return StatusResult{ Errors::unknownTable };
+      Index* thePrimary = findIndex(aName, theEntity->getPrimaryKey()->getName());
+      if (!thePrimary)
+          return StatusResult{ Errors::unknownIndex };
+
+      //every data block of a table carries the hash of its name, so the rows
+      //are released from the block headers without decoding any of them;
+      //only when another table hashes alike are they deleted row by row
+      bool theOwner = true;
+      for (auto& entity : entities)
+          theOwner = theOwner && (&entity == theEntity || entity.hashName() != theEntity->hashName());
+
+      uint32_t theCount = uint32_t(thePrimary->getSize());
+      StatusResult result{ Errors::noError };
+      if (theOwner) {
+          result = storage.freeBlocks(storage.getOwnedBlocks(theEntity->hashName(), BlockType::data_block));
+          for (auto& index : indexes) {
+              if (index.getTableName() == aName)
+                  index.clear();
           }
+          theEntity->setRowCount(0);
       }
-      return StatusResult{ Errors::noError };
+      else {
+          std::shared_ptr<Query> theQuery = std::make_shared<Query>();
+          theQuery->setFrom(theEntity);
+          result = deleteRows(theQuery);
+      }
+      if (!result)
+          return result;
+
+      //statistics describe rows that are gone
+      if (theEntity->getStatsBlock())
+          storage.markBlockAsFree(theEntity->getStatsBlock());
+      theEntity->setStatsBlock(0);
+      statistics.erase(aName);
+
+      changed = true;
+      return StatusResult{ Errors::noError, theCount };
   }
 
   StatusResult Database::alterTable(std::string aTableName, Keywords aMode, Attribute& anAtt) {
       if (!tables.count(aTableName))
           return StatusResult{ Errors::unknownTable };
 
-      StatusResult result{ Errors::noError };
+      //only the schema changes, rows are brought up to it as they are read
+      //and written back in it when they are next updated
       Entity* theEntity = getEntity(aTableName);
-      std::string primaryKey = theEntity->getPrimaryKey()->getName();
-
-      if (aMode == Keywords::add_kw)
-          theEntity->addAttribute(anAtt);
-      else
-          theEntity->dropAttribute(anAtt);
+      StatusResult result = aMode == Keywords::add_kw
+          ? theEntity->addAttribute(anAtt) : theEntity->dropAttribute(anAtt);
 
-      result = alterRow(anAtt, aMode, aTableName, primaryKey);
-
-      changed = true;
+      changed = changed || result;
       return result;
   }
   
@@ -398,33 +416,280 @@ namespace ECE141 {
       std::vector<KeyValues> keyValueList(aValues.size());
       buildKeyValueList(keyValueList, theTable, anAttNames, aValues);
 
-      //find all corresponding indexes
+      return insertKeyValues(*theTable, keyValueList);
+  }
+
+  //blocks written with one seek and flush during a bulk insert
+  const size_t kInsertBatch = 256;
+
+  StatusResult Database::insertKeyValues(Entity& anEntity, std::vector<KeyValues>& aRows, bool aKeepIds) {
+      //find all corresponding indexes, their entries are collected per index
       std::vector<Index*> tableIndexes;
       for (auto& index : indexes) {
-          if (index.getTableName() == theTable->getName())
+          if (index.getTableName() == anEntity.getName())
               tableIndexes.push_back(&index);
       }
-      
-      for (auto& keyValue : keyValueList) {
-          ++affectedRows;
-          auto blockNum = storage.getNextFreeBlockNum();
-          auto id = theTable->getIncrement();
-          keyValue["id"] = int(id);
+      std::vector<std::vector<std::pair<IndexKey, uint32_t>>> theEntries(tableIndexes.size());
+      for (auto& entries : theEntries)
+          entries.reserve(aRows.size());
+
+      //a block per row, rows that outgrow it chain more blocks below
+      std::vector<uint32_t> theBlockNums = storage.getFreeBlocks(aRows.size());
+      size_t theRefId = anEntity.hashName();
+
+      //consecutive blocks wait here until the run breaks or the batch fills;
+      //a row is written once the batch holding its first block is
+      std::vector<Block> theBatch;
+      theBatch.reserve(kInsertBatch);
+      uint32_t theBatchStart = 0;
+      size_t theBatchRow = 0;
+      size_t theWritten = 0;
+      StatusResult theResult{ Errors::noError };
+      auto flush = [&]() {
+          if (theResult && !theBatch.empty()) {
+              theResult = storage.writeBlocks(theBatchStart, theBatch.data(), theBatch.size());
+              if (theResult)
+                  theWritten = theBatchRow + theBatch.size();
+          }
+          theBatch.clear();
+      };
+
+      //the blocks chained to rows, given back if the rows are not written
+      std::vector<std::pair<size_t, std::vector<uint32_t>>> theChains;
+
+      //columns left out take their default
+      KeyValues theDefaults;
+      for (auto& att : anEntity.getAttributes()) {
+          if (att.hasDefaultValue())
+              theDefaults[att.getName()] = att.getDefaultValue();
+      }
+
+      PayloadBuffer theBuffer;
+      std::ostream theWriter(&theBuffer);
+      for (size_t i = 0; i < aRows.size() && theResult; ++i) {
+          KeyValues& keyValue = aRows[i];
+          uint32_t blockNum = theBlockNums[i];
+          keyValue.insert(theDefaults.begin(), theDefaults.end());
+          auto theGiven = aKeepIds ? keyValue.find("id") : keyValue.end();
+          uint32_t id = 0;
+          if (theGiven != keyValue.end() && std::holds_alternative<int>(theGiven->second))
+              anEntity.reserveIncrement(id = std::get<int>(theGiven->second));
+          else
+              keyValue["id"] = int(id = anEntity.getIncrement());
+
+          for (size_t j = 0; j < tableIndexes.size(); ++j) {
+              Value& theKey = keyValue[tableIndexes[j]->getFieldName()];
+              if (tableIndexes[j]->getType() == IndexType::intKey)
+                  theEntries[j].emplace_back(uint32_t(std::get<int>(theKey)), blockNum);
+              else
+                  theEntries[j].emplace_back(std::get<std::string>(theKey), blockNum);
+          }
+
+          if (!theBatch.empty() && (blockNum != theBatchStart + theBatch.size() || theBatch.size() == kInsertBatch))
+              flush();
+          if (!theResult)
+              break;
+          if (theBatch.empty()) {
+              theBatchStart = blockNum;
+              theBatchRow = i;
+          }
+          theBatch.emplace_back(BlockType::data_block);
+          Block& theBlock = theBatch.back();
+          theBlock.header.pos = 0;
+          theBlock.header.next = 0;
+          theBlock.header.refId = theRefId;
+          theBlock.header.id = id;
+
+          //encode straight into the block, falling back to a stream for rows
+          //longer than a payload
+          Row theRow(std::move(keyValue), blockNum, anEntity.getVersion());
+          theBuffer.reset(theBlock.payload);
+          theWriter.clear();
+          if (theRow.encode(theWriter) && theWriter) {
+              theBlock.header.size = theBuffer.size();
+              continue;
+          }
 
-          Row theRow(keyValue, blockNum);
           std::stringstream ss;
           theRow.encode(ss);
-          size_t size = ss.str().size();
+          std::string theData = ss.str();
+          size_t theCount = (theData.size() + kPayloadSize - 1) / kPayloadSize;
+          std::vector<uint32_t> theChain = storage.getFreeBlocks(theCount - 1);
+          theChains.emplace_back(i, theChain);
+          theChain.insert(theChain.begin(), blockNum);
+          for (size_t pos = 0; pos < theCount; ++pos) {
+              Block theNext(BlockType::data_block);
+              Block& thePart = pos ? theNext : theBlock;
+              thePart.header = theBlock.header;
+              thePart.header.pos = pos;
+              thePart.header.count = theCount;
+              thePart.header.next = pos + 1 < theCount ? theChain[pos + 1] : 0;
+              thePart.header.size = std::min(kPayloadSize, theData.size() - pos * kPayloadSize);
+              std::copy_n(theData.data() + pos * kPayloadSize, thePart.header.size, thePart.payload);
+              if (pos && theResult)
+                  theResult = storage.writeBlock(theChain[pos], thePart);
+          }
+          if (!theResult) {
+              //the rows before this one still go out
+              StatusResult theError = theResult;
+              theBatch.pop_back();
+              theResult = StatusResult{ Errors::noError };
+              flush();
+              theResult = theError;
+          }
+      }
+      flush();
+
+      //only the rows written are indexed and counted, the blocks of the
+      //others go back to the free list
+      std::vector<uint32_t> theUnused(theBlockNums.begin() + theWritten, theBlockNums.end());
+      for (auto& chain : theChains) {
+          if (chain.first >= theWritten)
+              theUnused.insert(theUnused.end(), chain.second.begin(), chain.second.end());
+      }
+      storage.returnBlocks(theUnused);
 
-          insertIndexes(tableIndexes, keyValue, blockNum);
-          
-          //setup storage info and write to data
-          StorageInfo info(theTable->hashName(), size, kNewBlock, BlockType::data_block, id);
-          storage.save(ss, info);
+      for (size_t j = 0; j < tableIndexes.size(); ++j) {
+          theEntries[j].resize(std::min(theEntries[j].size(), theWritten));
+          std::stable_sort(theEntries[j].begin(), theEntries[j].end(),
+              [](const auto& aLHS, const auto& aRHS) { return aLHS.first < aRHS.first; });
+          tableIndexes[j]->insertSorted(theEntries[j]);
       }
+
+      uint32_t affectedRows = uint32_t(theWritten);
+      anEntity.addRows(affectedRows);
       changed = true;
-      return StatusResult{ Errors::noError, affectedRows };
-  }  
+      theResult.value = affectedRows;
+      return theResult;
+  }
+
+  StatusResult Database::loadRows(const std::string& aTableName, const std::string& aPath, LoadFormat aFormat) {
+      Entity* theTable = getEntity(aTableName);
+      if (!theTable)
+          return StatusResult{ Errors::unknownTable };
+
+      std::ifstream theFile(aPath, std::ios::binary);
+      if (!theFile)
+          return StatusResult{ Errors::readError };
+
+      std::vector<LoadColumn> theColumns;
+      for (auto& att : theTable->getAttributes())
+          theColumns.push_back(LoadColumn{ att.getName(), att.getType(), att.getLength() });
+      RowParser theParser(theColumns, aFormat);
+
+      //CSV files name their fields on the first line
+      size_t theFirstLine = 1;
+      if (aFormat == LoadFormat::csv) {
+          std::string theHeader;
+          std::getline(theFile, theHeader);
+          StatusResult theResult = theParser.readHeader(theHeader);
+          if (!theResult)
+              return theResult;
+          theFirstLine = 2;
+      }
+
+      //a wave of chunks is parsed at once, then written in file order
+      size_t theParallelism = scheduler ? Config::getParallelism() : 1;
+      struct Chunk {
+          std::string             text;
+          size_t                  line = 0;
+          std::vector<KeyValues>  rows;
+          StatusResult            result{ Errors::noError };
+      };
+      std::vector<Chunk> theChunks(theParallelism);
+      ChunkReader theReader(theFile, aFormat, Config::getLoadChunkSize(), theFirstLine);
+
+      uint32_t theLoaded = 0;
+      for (bool more = true; more; ) {
+          size_t theCount = 0;
+          while (theCount < theParallelism && (more = theReader.next(theChunks[theCount].text, theChunks[theCount].line)))
+              ++theCount;
+
+          auto theParse = [&theParser](Chunk& aChunk) {
+              aChunk.rows.clear();
+              aChunk.result = theParser.parse(aChunk.text, aChunk.line, aChunk.rows);
+          };
+          if (theCount > 1) {
+              TaskGroup theGroup(*scheduler);
+              for (size_t i = 0; i < theCount; ++i)
+                  theGroup.run([&theParse, &theChunks, i] { theParse(theChunks[i]); });
+              theGroup.wait();
+          }
+          else if (theCount)
+              theParse(theChunks[0]);
+
+          //everything up to a bad record is loaded: the parser keeps the rows
+          //of a chunk before it, and the chunks after it are dropped
+          for (size_t i = 0; i < theCount; ++i) {
+              if (!theChunks[i].rows.empty()) {
+                  StatusResult theResult = insertKeyValues(*theTable, theChunks[i].rows);
+                  if (!theResult)
+                      return theResult;
+                  theLoaded += theResult.value;
+              }
+              if (!theChunks[i].result)
+                  return theChunks[i].result;
+          }
+      }
+      return StatusResult{ Errors::noError, theLoaded };
+  }
+
+  StatusResult Database::exportRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins,
+      const std::string& aPath, ExportFormat aFormat) {
+      if (!aQuery || !aQuery->getFrom())
+          return StatusResult{ Errors::unknownCommand };
+
+      //the columns a select shows, in their order; select * takes those of
+      //the joined tables after the ones of the first, a name once
+      StringList theColumns = aQuery->getSelects();
+      if (aQuery->selectAll()) {
+          theColumns.clear();
+          std::vector<Entity*> theTables{ aQuery->getFrom() };
+          for (auto& join : aJoins) {
+              if (Entity* theTable = getEntity(join.onRight.tableName))
+                  theTables.push_back(theTable);
+          }
+          for (auto* theTable : theTables) {
+              for (auto& att : theTable->getAttributes()) {
+                  if (std::find(theColumns.begin(), theColumns.end(), att.getName()) == theColumns.end())
+                      theColumns.push_back(att.getName());
+              }
+          }
+      }
+
+      //the buffer is set before the file opens, so that it takes effect
+      std::vector<char> theBuffer(Config::getExportBufferSize());
+      std::ofstream theFile;
+      theFile.rdbuf()->pubsetbuf(theBuffer.data(), theBuffer.size());
+      theFile.open(aPath, std::ios::binary | std::ios::trunc);
+      if (!theFile)
+          return StatusResult{ Errors::writeError };
+
+      std::unique_ptr<RowWriter> theWriter = RowWriter::create(aFormat, theFile, theColumns);
+      uint32_t theCount = 0;
+      RowVisitor theVisitor = [&](std::unique_ptr<Row> aRow) {
+          theWriter->write(aRow->getData());
+          ++theCount;
+          return bool(theFile);
+      };
+
+      //single table selects stream from the scan, joins and aggregates
+      //hand over their finished rows
+      StatusResult theResult{ Errors::noError };
+      if (aQuery->isAggregate() || aJoins.size()) {
+          RowCollection theRows;
+          theResult = queryRows(aQuery, aJoins, theRows);
+          for (size_t i = 0; theResult && i < theRows.size() && theVisitor(std::move(theRows[i])); ++i) {}
+      }
+      else
+          theResult = eachRow(aQuery, theVisitor);
+
+      theWriter->finish();
+      theFile.flush();
+      if (theResult && !theFile)
+          theResult = StatusResult{ Errors::writeError };
+      return StatusResult{ theResult.error, theCount };
+  }
 
   std::string Database::getPrimaryKey(std::shared_ptr<Query> aQuery) {
       //get the name of primary key attribute
@@ -436,99 +701,510 @@ namespace ECE141 {
       return "";
   }
 
-  StatusResult Database::selectRows(std::shared_ptr<Query> aQuery, RowCollection& aRows) {
+  //helper: an index key as a row value
+  static Value toValue(const IndexKey& aKey) {
+      if (auto* theNumber = std::get_if<uint32_t>(&aKey))
+          return int(*theNumber);
+      return std::get<std::string>(aKey);
+  }
+
+  TableStats Database::getTableStats(Entity& anEntity) {
+      TableStats theStats;
+      theStats.rows = anEntity.getRowCount();
+
+      //analyzed columns that still exist, capped at the current row count
+      auto theStored = statistics.find(anEntity.getName());
+      if (theStored != statistics.end()) {
+          for (auto& column : theStored->second.columns) {
+              if (!anEntity.getAttribute(column.first))
+                  continue;
+              ColumnStats& theColumn = theStats.columns[column.first] = column.second;
+              theColumn.distinct = std::min(theColumn.distinct, theStats.rows);
+          }
+      }
+
+      Attribute* theKey = anEntity.getPrimaryKey();
+      if (!theKey)
+          return theStats;
+
+      //every row has a key of its own, the index knows the smallest and largest
+      ColumnStats& theColumn = theStats.columns[theKey->getName()];
+      theColumn.nulls = 0;
+      theColumn.distinct = theStats.rows;
+      if (Index* theIndex = findIndex(anEntity.getName(), theKey->getName())) {
+          auto theFirst = theIndex->firstKey();
+          auto theLast = theIndex->lastKey();
+          theColumn.min = theFirst ? std::optional<Value>(toValue(*theFirst)) : std::nullopt;
+          theColumn.max = theLast ? std::optional<Value>(toValue(*theLast)) : std::nullopt;
+      }
+      return theStats;
+  }
+
+  StatusResult Database::analyzeTable(const std::string& aTableName) {
+      Entity* theEntity = getEntity(aTableName);
+      if (!theEntity)
+          return StatusResult{ Errors::unknownTable };
+
+      StringList theColumns;
+      for (auto& att : theEntity->getAttributes())
+          theColumns.push_back(att.getName());
+      StatsCollector theCollector(theColumns);
+
+      //one pass over every row
+      std::shared_ptr<Query> theQuery = std::make_shared<Query>();
+      theQuery->setEntityName(aTableName).setFrom(theEntity);
+      theQuery->setSelectAll(true);
+      StatusResult theResult = eachRow(theQuery, [&theCollector](std::unique_ptr<Row> aRow) {
+          theCollector.add(aRow->getData());
+          return true;
+          });
+      if (!theResult)
+          return theResult;
+      TableStats& theStats = statistics[aTableName] = theCollector.finish();
+
+      //the new statistics replace the blocks of the old ones
+      if (theEntity->getStatsBlock())
+          storage.markBlockAsFree(theEntity->getStatsBlock());
+      std::stringstream ss;
+      theStats.encode(ss);
+      theEntity->setStatsBlock(storage.getNextFreeBlockNum());
+      StorageInfo theInfo(theEntity->hashName(), ss.str().size(), kNewBlock, BlockType::stats_block);
+      storage.save(ss, theInfo);
+
+      changed = true;
+      return StatusResult{ Errors::noError, uint32_t(theStats.rows) };
+  }
+
+  ScanPlan Database::planScan(std::shared_ptr<Query> aQuery, Index& anIndex) {
+      return Planner().planScan(aQuery->getFilters(), getTableStats(*aQuery->getFrom()),
+          anIndex.getFieldName(), anIndex.getType());
+  }
+
+  //plan details: "by zipcode desc, id" and "offset 5, limit 10"
+  static std::string orderDetail(const Query& aQuery) {
+      std::string theDetail;
+      StringList theOrder = aQuery.getOrderBy();
+      std::vector<bool> theAscend = aQuery.getAscend();
+      for (size_t i = 0; i < theOrder.size(); ++i) {
+          theDetail += (i ? ", " : "by ") + theOrder[i];
+          if (i < theAscend.size() && !theAscend[i])
+              theDetail += " desc";
+      }
+      return theDetail;
+  }
+
+  static bool hasWindow(const Query& aQuery) {
+      return aQuery.getOffset() > 0 || aQuery.getLimit() != std::numeric_limits<int>::max();
+  }
+
+  static std::string windowDetail(const Query& aQuery) {
+      std::string theDetail;
+      if (aQuery.getOffset() > 0)
+          theDetail = "offset " + std::to_string(aQuery.getOffset());
+      if (aQuery.getLimit() != std::numeric_limits<int>::max())
+          theDetail += (theDetail.size() ? ", limit " : "limit ") + std::to_string(aQuery.getLimit());
+      return theDetail;
+  }
+
+  StatusResult Database::queryRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins, RowCollection& aRows) {
       if (!aQuery)
           return StatusResult{ Errors::unknownCommand };
+      if (aQuery->isAggregate())
+          return aggregateRows(aQuery, aJoins, aRows);
+      if (aJoins.size())
+          return selectJoinRows(aQuery, aJoins, aRows);
+      return selectRows(aQuery, aRows);
+  }
+
+  StatusResult Database::explainRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins, QueryPlan& aPlan) {
+      if (!aQuery || !aQuery->getFrom())
+          return StatusResult{ Errors::unknownCommand };
+
+      plan = &aPlan;
+      RowCollection theRows;
+      StatusResult theResult;
+      {
+          PlanScope theStep(plan, "select", aQuery->getFrom()->getName());
+          theResult = queryRows(aQuery, aJoins, theRows);
+          theStep.setRows(theRows.size());
+      }
+      plan = nullptr;
+      return theResult;
+  }
+
+  StatusResult Database::selectRows(std::shared_ptr<Query> aQuery, RowCollection& aRows) {
+      return eachRow(aQuery, [&aRows](std::unique_ptr<Row> aRow) {
+          aRows.push_back(std::move(aRow));
+          return true;
+          });
+  }
+
+  //blocks per unit of work handed to the scheduler
+  const size_t kMorselSize = 64;
+
+  StatusResult Database::scanRows(Index& anIndex, std::shared_ptr<Query> aQuery, const ScanPlan& aScan,
+      bool anAscending, const StringSet* aProjection, const RowVisitor& aVisitor) {
+      size_t theParallelism = aQuery->getParallelism();
+      Entity& theEntity = *aQuery->getFrom();
+
+      //the block numbers of the range in visiting order, cut into morsels
+      std::vector<uint32_t> theBlocks;
+      if (scheduler && theParallelism > 1) {
+          anIndex.eachKV(aScan.range, [&theBlocks](const IndexKey&, uint32_t aBlockNum) {
+              theBlocks.push_back(aBlockNum);
+              return true;
+              }, anAscending);
+      }
+      //small ranges are not worth the hand-off
+      bool isParallel = theBlocks.size() >= 2 * kMorselSize;
+
+      std::string theDetail = anIndex.getTableName() + " by " + anIndex.getFieldName();
+      if (!anAscending)
+          theDetail += " desc";
+      if (!aScan.range.isFull())
+          theDetail += ", " + Planner::describe(aScan.range, anIndex.getFieldName());
+      if (aQuery->hasFilters())
+          theDetail += ", filtered";
+      if (isParallel)
+          theDetail += ", " + std::to_string(theParallelism) + " workers";
+      theDetail += ", ~" + std::to_string(std::llround(aScan.rows)) + " rows";
+      PlanScope theStep(plan, aScan.range.isFull() ? "scan" : "range scan", theDetail);
+      if (theStep.describeOnly())
+          return StatusResult{ Errors::noError };
+
+      if (!isParallel) {
+          bool cancelled = false;
+          anIndex.each(aScan.range, [&](const Block& theBlock, uint32_t blockIndex)->bool {
+              if ((cancelled = aQuery->isCancelled()))
+                  return false;
+              std::unique_ptr<Row> row = decodeRow(storage, theBlock, aProjection, theEntity);
+              if (!aQuery->matches(row->getData()))
+                  return true;
+              theStep.addRows();
+              return aVisitor(std::move(row));
+              }, anAscending);
+          return StatusResult{ cancelled ? Errors::userTerminated : Errors::noError };
+      }
+
+      struct Morsel {
+          RowCollection       rows;
+          StatusResult        result{ Errors::noError };
+          std::atomic<bool>   done{ false };
+      };
+      size_t theCount = (theBlocks.size() + kMorselSize - 1) / kMorselSize;
+      std::vector<Morsel> theMorsels(theCount);
+      std::string thePath = Config::getDBPath(name);
+      //declared after what its tasks use, so it waits for them first
+      TaskGroup theGroup(*scheduler, aQuery->getCancelFlag());
+
+      //each morsel reads through its own stream and keeps the matching rows
+      size_t theSubmitted = 0;
+      auto theSubmit = [&](size_t aMorsel) {
+          theGroup.run([&, aMorsel] {
+              Morsel& theMorsel = theMorsels[aMorsel];
+              std::fstream theStream(thePath.c_str(), std::fstream::binary | std::fstream::in);
+              BlockIO theIO(theStream);
+              Block theBlock;
+              size_t theEnd = std::min(theBlocks.size(), (aMorsel + 1) * kMorselSize);
+              for (size_t i = aMorsel * kMorselSize; i < theEnd && !theGroup.isCancelled(); ++i) {
+                  if (!(theMorsel.result = theIO.readBlock(theBlocks[i], theBlock)))
+                      break;
+                  std::unique_ptr<Row> row = decodeRow(theIO, theBlock, aProjection, theEntity);
+                  if (aQuery->matches(row->getData()))
+                      theMorsel.rows.push_back(std::move(row));
+              }
+              theMorsel.done = true;
+              });
+      };
+
+      //at most one morsel per degree of parallelism is in flight
+      for (; theSubmitted < std::min(theCount, theParallelism); ++theSubmitted)
+          theSubmit(theSubmitted);
+
+      //hand the buffers over in morsel order so rows keep the index order,
+      //a visitor that has enough cancels the morsels not yet read
+      StatusResult theResult{ Errors::noError };
+      for (size_t i = 0; i < theCount && !theGroup.isCancelled(); ++i) {
+          theGroup.wait([&] { return theMorsels[i].done || theGroup.isCancelled(); });
+          if (theGroup.isCancelled())
+              break;
+          if (!(theResult = theMorsels[i].result)) {
+              theGroup.cancel();
+              break;
+          }
+          theStep.addRows(theMorsels[i].rows.size());
+          for (auto& row : theMorsels[i].rows) {
+              if (!aVisitor(std::move(row))) {
+                  theGroup.cancel();
+                  break;
+              }
+          }
+          theMorsels[i].rows.clear();
+          if (theSubmitted < theCount)
+              theSubmit(theSubmitted++);
+      }
+
+      if (aQuery->isCancelled())
+          theResult = StatusResult{ Errors::userTerminated };
+      return theResult;
+  }
 
-      auto theId = aQuery->getFrom()->hashName(); //reference ID of the entity
-      int count = 0;
+  StatusResult Database::eachRow(std::shared_ptr<Query> aQuery, const RowVisitor& aVisitor) {
+      if (!aQuery)
+          return StatusResult{ Errors::unknownCommand };
 
       std::string primaryKey = getPrimaryKey(aQuery);
+      StringList theOrder = aQuery->getOrderBy();
+      std::vector<bool> theAscend = aQuery->getAscend();
+
+      //number of matching rows needed to fill offset + limit
+      size_t theOffset = std::max(aQuery->getOffset(), 0);
+      size_t theWindow = std::numeric_limits<size_t>::max();
+      bool hasLimit = aQuery->getLimit() != std::numeric_limits<int>::max();
+      if (hasLimit)
+          theWindow = theOffset + std::max(aQuery->getLimit(), 0);
+      if (!theWindow)
+          return StatusResult{ Errors::noError };
+
+      //the primary key index already yields rows in key order
+      bool indexOrdered = theOrder.empty() || theOrder[0] == primaryKey;
+      bool ascending = theOrder.empty() || theAscend[0];
+
+      //ORDER BY ... LIMIT k keeps only the best k rows, a full
+      //ORDER BY goes through the sorter and may spill to disk
+      RowComparator theComparator(theOrder, theAscend);
+      TopK theTopK(theComparator, theWindow);
+      ExternalSorter theSorter(theComparator);
+      bool useHeap = !indexOrdered && hasLimit;
+
+      //distinct rows: nothing to drop when the primary key is compared,
+      //adjacent duplicates when the sorted output groups equal values,
+      //a hash set of seen keys otherwise
+      StringList theDistinct = aQuery->getDistinctFields();
+      bool isUnique = !aQuery->isDistinct()
+          || std::find(theDistinct.begin(), theDistinct.end(), primaryKey) != theDistinct.end();
+      bool sortedOnDistinct = !isUnique && !useHeap && theOrder.size() >= theDistinct.size()
+          && StringSet(theOrder.begin(), theOrder.begin() + theDistinct.size())
+          == StringSet(theDistinct.begin(), theDistinct.end());
+      DistinctFilter theDistinctFilter(theDistinct, sortedOnDistinct);
+
+      //only decode the fields the query actually uses
+      StringSet theFields;
+      const StringSet* theProjection = aQuery->getProjection(theFields) ? &theFields : nullptr;
+
+      //plan steps, outermost first; a hash distinct runs below the sort
+      PlanScope theLimitStep(hasWindow(*aQuery) ? plan : nullptr, "limit", windowDetail(*aQuery));
+      PlanScope theAdjacentStep(sortedOnDistinct ? plan : nullptr, "distinct", "adjacent rows");
+      PlanScope theSortStep(indexOrdered ? nullptr : plan, useHeap ? "top-k" : "sort",
+          orderDetail(*aQuery) + (useHeap ? ", bounded heap" : ", external merge"));
+      PlanScope theHashStep(isUnique || sortedOnDistinct ? nullptr : plan, "distinct", "hash set");
+
+      StatusResult theResult{ Errors::noError };
+      size_t count = 0;
+      //read the whole table, or only the key range the filters allow
+      if (Index* theIndex = findIndex(aQuery->getFrom()->getName(), primaryKey)) {
+          StatusResult theScanResult = scanRows(*theIndex, aQuery, planScan(aQuery, *theIndex), ascending, theProjection, [&](std::unique_ptr<Row> row)->bool {
+              if (!isUnique && !sortedOnDistinct) {
+                  if (!theDistinctFilter.isNew(*row))
+                      return true;
+                  theHashStep.addRows();
+              }
 
-      //find the primary key index
-      for (auto& index : indexes) {
-          if (index.getTableName() == aQuery->getFrom()->getName() && index.getFieldName() == primaryKey) {
-              index.each([&](const Block& theBlock, uint32_t blockIndex)->bool {
-                  //read row data
-                  std::stringstream ss;
-                  ss.write(theBlock.payload, theBlock.header.size);
-                  std::unique_ptr<Row> row = std::make_unique<Row>();                  
-                  row->decode(ss);
-
-                  //push to the collections if the row matches the query
-                  if (aQuery->matches(row->getData())) {
-                      aRows.push_back(std::move(row));
-                      ++count;
+              //rows arrive in final order, skip the offset and stop at the limit
+              if (indexOrdered) {
+                  if (count++ >= theOffset) {
+                      theLimitStep.addRows();
+                      if (!aVisitor(std::move(row)))
+                          return false;
                   }
-                  if (count == aQuery->getLimit())
-                      return false;
+                  return count < theWindow;
+              }
 
+              if (useHeap)
+                  theTopK.push(std::move(row));
+              else
+                  theResult = theSorter.add(std::move(row));
+              return bool(theResult);
+              });
+          if (theResult)
+              theResult = theScanResult;
+      }
+
+      if (!theResult || indexOrdered)
+          return theResult;
+      if (theSorter.getRunCount())
+          theSortStep.addDetail(", " + std::to_string(theSorter.getRunCount()) + " runs on disk");
+
+      //emit the ordered rows past the offset
+      count = 0;
+      auto theEmit = [&](std::unique_ptr<Row> aRow) {
+          theSortStep.addRows();
+          if (sortedOnDistinct) {
+              if (!theDistinctFilter.isNew(*aRow))
                   return true;
-                  }
-              );
-              break;
+              theAdjacentStep.addRows();
+          }
+          if (count++ < theOffset)
+              return true;
+          theLimitStep.addRows();
+          return aVisitor(std::move(aRow));
+      };
+
+      if (useHeap) {
+          RowCollection theRows;
+          theTopK.finish(theRows);
+          for (auto& row : theRows) {
+              if (!theEmit(std::move(row)))
+                  break;
           }
+          return theResult;
       }
-      return StatusResult{ Errors::noError };
+
+      return theSorter.each(theEmit);
+  }
+
+  //keep only the selected fields of a joined row, missing ones show as NULL
+  static std::unique_ptr<Row> projectJoinedRow(std::shared_ptr<Query> aQuery, Row& aRow) {
+      KeyValues& theData = aRow.getData();
+      KeyValues keyValue;
+      for (auto& attName : aQuery->getSelects()) {
+          auto theValue = theData.find(attName);
+          if (theValue != theData.end())
+              keyValue[attName] = theValue->second;
+          else
+              keyValue[attName] = std::string("NULL");
+      }
+      return std::make_unique<Row>(keyValue, 0);
   }
 
-  static std::ostream& operator<< (std::ostream& out, const Value& aValue) {
-      std::visit([&out](auto const& aValue)
-      { out <<  aValue; }, aValue);
-      return out;
+  //plan steps of a result that is ordered and cut once it is materialized,
+  //opened before the operators that produce it
+  struct WindowSteps {
+      WindowSteps(QueryPlan* aPlan, const Query& aQuery)
+          : limit(hasWindow(aQuery) ? aPlan : nullptr, "limit", windowDetail(aQuery)),
+          distinct(aQuery.isDistinct() ? aPlan : nullptr, "distinct", "hash set"),
+          sort(aQuery.getOrderBy().size() ? aPlan : nullptr, "sort", orderDetail(aQuery) + ", in memory") {}
+
+      PlanScope limit;
+      PlanScope distinct;
+      PlanScope sort;
+  };
+
+  //order a materialized result, drop distinct duplicates and cut it down to offset + limit
+  static void applyWindow(std::shared_ptr<Query> aQuery, RowCollection& aRows, WindowSteps& aSteps) {
+      if (aQuery->getOrderBy().size())
+          sortRows(aRows, RowComparator(aQuery->getOrderBy(), aQuery->getAscend()));
+      aSteps.sort.setRows(aRows.size());
+
+      if (aQuery->isDistinct()) {
+          DistinctFilter theFilter(aQuery->getDistinctFields());
+          aRows.erase(std::remove_if(aRows.begin(), aRows.end(),
+              [&theFilter](std::unique_ptr<Row>& aRow) { return !theFilter.isNew(*aRow); }), aRows.end());
+      }
+      aSteps.distinct.setRows(aRows.size());
+
+      size_t theOffset = std::max(aQuery->getOffset(), 0);
+      size_t theLimit = std::max(aQuery->getLimit(), 0);
+
+      aRows.erase(aRows.begin(), aRows.begin() + std::min(theOffset, aRows.size()));
+      if (theLimit < aRows.size())
+          aRows.erase(aRows.begin() + theLimit, aRows.end());
+      aSteps.limit.setRows(aRows.size());
   }
 
-  std::shared_ptr<Query> Database::buildQuery(Join& aJoin, Value aValue) {
-      std::shared_ptr<Query> theQuery = std::make_shared<Query>();
-      theQuery->setEntityName(aJoin.onRight.tableName);
-      theQuery->setSelectAll(true);
-      for (auto& entity : entities) {
-          if (entity.getName() == theQuery->getEntityName()) {
-              theQuery->setFrom(&entity);
-              break;
+  //convert a field value to the key type of an index, false if it can't match
+  static bool toIndexKey(const Value& aValue, IndexType aType, IndexKey& aKey) {
+      if (aType == IndexType::strKey) {
+          if (auto* theString = std::get_if<std::string>(&aValue)) {
+              aKey = *theString;
+              return true;
           }
+          return false;
       }
 
-      std::stringstream ss;
-      ss << aJoin.onRight.fieldName << " = " << aValue;
+      double theNumber = 0;
+      if (auto* theInt = std::get_if<int>(&aValue))
+          theNumber = *theInt;
+      else if (auto* theDouble = std::get_if<double>(&aValue))
+          theNumber = *theDouble;
+      else
+          return false;
 
-      Tokenizer theTokenizer(ss);
-      theTokenizer.tokenize();
-      theQuery->parseFilters(theTokenizer);
+      if (theNumber < 0 || theNumber != uint32_t(theNumber))
+          return false;
+      aKey = uint32_t(theNumber);
+      return true;
+  }
 
-      return theQuery;
+  StatusResult Database::probeRows(Index& anIndex, const std::set<IndexKey>& aKeys,
+      const StringSet* aProjection, RowCollection& aRows) {
+      PlanScope theStep(plan, "index lookup", anIndex.getTableName() + " by " + anIndex.getFieldName());
+      Entity* theEntity = getEntity(anIndex.getTableName());
+      if (!theEntity)
+          return StatusResult{ Errors::unknownTable };
+      anIndex.each(aKeys, [&](const Block& theBlock, uint32_t blockIndex)->bool {
+          theStep.addRows();
+          aRows.push_back(decodeRow(storage, theBlock, aProjection, *theEntity));
+          return true;
+          });
+      return StatusResult{ Errors::noError };
   }
 
-  static void buildJoinedRow(std::shared_ptr<Query> aQuery, RowCollection& aCollection, 
-      std::unique_ptr<Row> aLeftRow, RowCollection& aRightRows) {
-      KeyValues leftData = aLeftRow->getData();
-      if (aRightRows.size() == 0) {
-          KeyValues keyValue;
-          for (auto& attName : aQuery->getSelects()) {
-              if (leftData.count(attName)) {
-                  keyValue[attName] = leftData[attName];
-              }
-              else {
-                  keyValue[attName] = std::string("NULL");
-              }
+  //keys count as distinct unless the statistics of the field know better
+  JoinInput Database::joinInput(const TableField& aField, double aRows) {
+      JoinInput theInput;
+      theInput.rows = aRows;
+      theInput.distinct = aRows;
+      if (Entity* theTable = getEntity(aField.tableName)) {
+          if (size_t theCount = getTableStats(*theTable).getDistinct(aField.fieldName))
+              theInput.distinct = std::min<double>(double(theCount), aRows);
+      }
+      return theInput;
+  }
+
+  //outer joins keep their order; so do tables sharing a column name, since
+  //a merged row keeps the value of the table joined first
+  std::vector<Join> Database::orderJoins(std::shared_ptr<Query> aQuery, const std::vector<Join>& aJoins,
+      double aLeftRows) {
+      StringSet theColumns;
+      for (auto& join : aJoins) {
+          Entity* theTable = getEntity(join.onRight.tableName);
+          if (!theTable || join.joinType == Keywords::left_kw || join.joinType == Keywords::right_kw)
+              return aJoins;
+          for (auto& att : theTable->getAttributes()) {
+              if (!theColumns.insert(att.getName()).second)
+                  return aJoins;
           }
-          std::unique_ptr<Row> theRow = std::make_unique<Row>(keyValue, 0);
-          aCollection.push_back(std::move(theRow));
       }
-      for (auto& rRow : aRightRows) {
-          KeyValues rightData = rRow->getData();
-          KeyValues keyValue;
-          for (auto& attName : aQuery->getSelects()) {
-              if (leftData.count(attName)) {
-                  keyValue[attName] = leftData[attName];
-              }
-              else {
-                  keyValue[attName] = rightData[attName];
+
+      std::vector<Join> theRemaining(aJoins);
+      std::vector<Join> theOrdered;
+      StringSet theTables{ aQuery->getFrom()->getName() };
+      double theRows = aLeftRows;
+      while (theRemaining.size()) {
+          auto theNext = theRemaining.end();
+          double theBest = std::numeric_limits<double>::infinity();
+          for (auto it = theRemaining.begin(); it != theRemaining.end(); ++it) {
+              if (!theTables.count(it->onLeft.tableName))
+                  continue;
+              Entity* theRight = getEntity(it->onRight.tableName);
+              double theOutput = Planner::joinRows(joinInput(it->onLeft, theRows),
+                  joinInput(it->onRight, theRight->getRowCount()), false);
+              if (theOutput < theBest) {
+                  theBest = theOutput;
+                  theNext = it;
               }
           }
-          std::unique_ptr<Row> theRow = std::make_unique<Row>(keyValue, 0);
-          aCollection.push_back(std::move(theRow));
+          //a join on a table that is never joined, leave it to fail as written
+          if (theNext == theRemaining.end())
+              return aJoins;
+
+          theRows = theBest;
+          theTables.insert(theNext->onRight.tableName);
+          theOrdered.push_back(*theNext);
+          theRemaining.erase(theNext);
       }
+      return theOrdered;
   }
 
   StatusResult Database::selectJoinRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins, 
@@ -536,120 +1212,794 @@ namespace ECE141 {
       if (!aQuery)
           return StatusResult{ Errors::unknownCommand };
 
-      auto theId = aQuery->getFrom()->hashName(); //reference ID of the entity
-      int count = 0;
+      //fields each side must decode: the query fields plus the join columns
+      StringList theFields;
+      if (!aQuery->selectAll()) {
+          theFields = aQuery->getSelects();
+          for (auto& field : aQuery->getOrderBy())
+              theFields.push_back(field);
+          for (auto& join : aJoins) {
+              theFields.push_back(join.onLeft.fieldName);
+              theFields.push_back(join.onRight.fieldName);
+          }
+      }
 
-      std::string primaryKey = getPrimaryKey(aQuery);
+      //the left table is scanned once, the where clause applies to it
+      std::shared_ptr<Query> theLeft = std::make_shared<Query>(*aQuery);
+      theLeft->clearWindow();
+      if (!aQuery->selectAll())
+          theLeft->setSelect(theFields);
+
+      StringSet theRightFields(theFields.begin(), theFields.end());
+      const StringSet* theRightProjection = aQuery->selectAll() ? nullptr : &theRightFields;
+
+      WindowSteps theWindowSteps(plan, *aQuery);
+
+      RowCollection theRows;
+      bool loaded = false; //left rows are materialized in theRows
+      StatusResult theResult{ Errors::noError };
+
+      //rows the where clause leaves of the left table, then of each join
+      //result; estimates until a join has actually run
+      Planner thePlanner;
+      TableStats theLeftStats = getTableStats(*aQuery->getFrom());
+      double theLeftRows = theLeftStats.rows * thePlanner.selectivity(aQuery->getFilters(), theLeftStats);
+
+      for (auto& join : orderJoins(aQuery, aJoins, theLeftRows)) {
+          Entity* theRightTable = getEntity(join.onRight.tableName);
+          if (!theRightTable)
+              return StatusResult{ Errors::unknownTable };
+
+          //both inputs may already come in key order from their primary key indexes
+          Index* theIndex = findIndex(join.onRight.tableName, join.onRight.fieldName);
+          JoinInput theLeftInput = joinInput(join.onLeft, theLeftRows);
+          theLeftInput.ordered = !loaded && join.onLeft.fieldName == getPrimaryKey(aQuery);
+          JoinInput theRightInput = joinInput(join.onRight, theRightTable->getRowCount());
+          theRightInput.indexed = theRightInput.ordered = theIndex != nullptr;
+
+          bool isOuter = join.joinType == Keywords::left_kw || join.joinType == Keywords::right_kw;
+          JoinPlan theJoinPlan = thePlanner.planJoin(theLeftInput, theRightInput, isOuter);
+          bool useMerge = theJoinPlan.method == JoinMethod::merge;
+          bool useIndex = theJoinPlan.method == JoinMethod::indexLoop;
+
+          std::string theDetail = join.onLeft.tableName + "." + join.onLeft.fieldName + " = "
+              + join.onRight.tableName + "." + join.onRight.fieldName;
+          if (isOuter)
+              theDetail += ", outer";
+          theDetail += ", ~" + std::to_string(std::llround(theJoinPlan.rows)) + " rows";
+          PlanScope theJoinStep(plan, Planner::describe(theJoinPlan.method), theDetail);
+          //a described join has no rows, the next one goes on the estimate
+          auto theJoinDone = [&]() {
+              theJoinStep.setRows(theRows.size());
+              theLeftRows = theJoinStep.describeOnly() ? theJoinPlan.rows : double(theRows.size());
+          };
+
+          if (useMerge) {
+              //sort-merge join: stream both sides in key order in one pass
+              RowCollection theJoined;
+              ExternalSorter theRightSorter(RowComparator({ join.onRight.fieldName }, { true }));
+              std::optional<IndexKey> theCursor;
+              RowSource theRightSource;
+
+              if (theIndex) {
+                  theRightSource = [&](std::unique_ptr<Row>& aRow) {
+                      Block theBlock;
+                      if (!theIndex->nextBlock(theCursor, theBlock))
+                          return false;
+                      aRow = decodeRow(storage, theBlock, theRightProjection, *theRightTable);
+                      return true;
+                  };
+              }
+              else {
+                  std::shared_ptr<Query> theRight = std::make_shared<Query>();
+                  theRight->setEntityName(join.onRight.tableName).setFrom(theRightTable);
+                  if (aQuery->selectAll())
+                      theRight->setSelectAll(true);
+                  else
+                      theRight->setSelect(theFields);
+
+                  PlanScope theSortStep(plan, "sort", "by " + join.onRight.fieldName + ", external merge");
+                  theResult = eachRow(theRight, [&](std::unique_ptr<Row> aRow) {
+                      theSortStep.addRows();
+                      return bool(theResult = theRightSorter.add(std::move(aRow)));
+                      });
+                  if (!theResult || !(theResult = theRightSorter.open()))
+                      return theResult;
+                  if (theRightSorter.getRunCount())
+                      theSortStep.addDetail(", " + std::to_string(theRightSorter.getRunCount()) + " runs on disk");
+                  theRightSource = [&](std::unique_ptr<Row>& aRow) { return theRightSorter.next(aRow); };
+              }
 
-      //find the primary key index
-      for (auto& index : indexes) {
-          if (index.getTableName() == aQuery->getFrom()->getName() && index.getFieldName() == primaryKey) {
-              index.each([&](const Block& theBlock, uint32_t blockIndex)->bool {
-                  //read row data
-                  std::stringstream ss;
-                  ss.write(theBlock.payload, theBlock.header.size);
-                  std::unique_ptr<Row> row = std::make_unique<Row>();
-                  row->decode(ss);
-
-                  for (auto& join : aJoins) {
-                      auto theQuery = buildQuery(join, row->getValue(join.onLeft.fieldName));
-                      RowCollection rightRows;
-                      StatusResult result = selectRows(theQuery, rightRows);
-                      if (!result)
-                          return result;
-
-                      buildJoinedRow(aQuery, aRows, std::move(row), rightRows);
-                  }
+              MergeJoin theJoin(join, theRightSource, [&theJoined](std::unique_ptr<Row> aRow) {
+                  theJoined.push_back(std::move(aRow));
+                  return true;
+                  });
 
-                  return true; });
-              break;
+              if (loaded) {
+                  sortRows(theRows, RowComparator({ join.onLeft.fieldName }, { true }));
+                  for (auto& row : theRows)
+                      theJoin.push(std::move(row));
+              }
+              else {
+                  //the left scan sorts (or reads the index) on the join key
+                  std::shared_ptr<Query> theOrdered = std::make_shared<Query>(*theLeft);
+                  theOrdered->setOrderBy(join.onLeft.fieldName);
+                  theResult = eachRow(theOrdered, [&theJoin](std::unique_ptr<Row> aRow) {
+                      return theJoin.push(std::move(aRow));
+                      });
+                  if (!theResult)
+                      return theResult;
+              }
+
+              theRows = std::move(theJoined);
+              loaded = true;
+              theJoinDone();
+              continue;
+          }
+
+          if (!loaded) {
+              if (!(theResult = selectRows(theLeft, theRows)))
+                  return theResult;
+              loaded = true;
+          }
+
+          RowCollection theRightRows;
+
+          //index nested-loop join: look up each distinct left key in the
+          //right table's index, probing in key order
+          if (useIndex) {
+              std::set<IndexKey> theKeys;
+              IndexKey theKey;
+              for (auto& row : theRows) {
+                  KeyValues& theData = row->getData();
+                  auto theValue = theData.find(join.onLeft.fieldName);
+                  if (theValue != theData.end() && toIndexKey(theValue->second, theIndex->getType(), theKey))
+                      theKeys.insert(theKey);
+              }
+
+              if (!(theResult = probeRows(*theIndex, theKeys, theRightProjection, theRightRows)))
+                  return theResult;
+          }
+          //otherwise scan the right table once
+          else {
+              std::shared_ptr<Query> theRight = std::make_shared<Query>();
+              theRight->setEntityName(join.onRight.tableName).setFrom(theRightTable);
+              if (aQuery->selectAll())
+                  theRight->setSelectAll(true);
+              else
+                  theRight->setSelect(theFields);
+
+              if (!(theResult = selectRows(theRight, theRightRows)))
+                  return theResult;
           }
+
+          //probed rows are matched back to the left rows the same way
+          RowCollection theJoined;
+          theResult = HashJoin(join).run(theRows, theRightRows, [&theJoined](std::unique_ptr<Row> aRow) {
+              theJoined.push_back(std::move(aRow));
+              return true;
+              });
+          if (!theResult)
+              return theResult;
+          theRows = std::move(theJoined);
+          theJoinDone();
       }
 
+      //no joins at all, just the left rows
+      if (!loaded && !(theResult = selectRows(theLeft, theRows)))
+          return theResult;
+
+      applyWindow(aQuery, theRows, theWindowSteps);
+
+      for (auto& row : theRows) {
+          if (aQuery->selectAll())
+              aRows.push_back(std::move(row));
+          else
+              aRows.push_back(projectJoinedRow(aQuery, *row));
+      }
       return StatusResult{ Errors::noError };
   }
 
-  StatusResult Database::updateRows(std::shared_ptr<Query> aQuery, KeyValues& anUpdates) {
+  bool Database::aggregateFromMetadata(std::shared_ptr<Query> aQuery, RowCollection& aRows) {
+      if (aQuery->hasFilters() || aQuery->getGroupBy().size())
+          return false;
+
+      Entity* theTable = aQuery->getFrom();
+      std::string primaryKey = getPrimaryKey(aQuery);
+      Index* theIndex = findIndex(theTable->getName(), primaryKey);
+      if (!theIndex)
+          return false;
+
+      //only the row count and the primary key index ends are known
+      KeyValues theData;
+      for (auto& aggregate : aQuery->getAggregates()) {
+          bool onKey = aggregate.field == primaryKey;
+          if (aggregate.function == Keywords::count_kw && (aggregate.field == "*" || onKey)) {
+              theData[aggregate.name] = int(theTable->getRowCount());
+          }
+          else if (onKey && (aggregate.function == Keywords::min_kw || aggregate.function == Keywords::max_kw)) {
+              auto theKey = aggregate.function == Keywords::min_kw ? theIndex->firstKey() : theIndex->lastKey();
+              theData[aggregate.name] = theKey ? toValue(*theKey) : Value(std::string("NULL"));
+          }
+          else
+              return false;
+      }
+
+      //one row, so the window only matters for offset or limit 0
+      if (aQuery->getOffset() <= 0 && aQuery->getLimit() > 0)
+          aRows.push_back(std::make_unique<Row>(theData, 0));
+      return true;
+  }
+
+  StatusResult Database::aggregateRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins,
+      RowCollection& aRows) {
       if (!aQuery)
           return StatusResult{ Errors::unknownCommand };
 
-      auto theId = aQuery->getFrom()->hashName(); //reference ID of the entity
-      uint32_t count = 0;
+      //count(*), min(pk) and max(pk) need no scan
+      if (aJoins.empty() && aggregateFromMetadata(aQuery, aRows)) {
+          PlanScope theStep(plan, "aggregate", "from row count and key index");
+          theStep.setRows(aRows.size());
+          return StatusResult{ Errors::noError };
+      }
 
-      std::string primaryKey = getPrimaryKey(aQuery);
+      StringSet theOutputs; //names of the aggregate columns
+      StringList theInputs = aQuery->getGroupBy();
+      for (auto& aggregate : aQuery->getAggregates()) {
+          theOutputs.insert(aggregate.name);
+          if (aggregate.field != "*")
+              theInputs.push_back(aggregate.field);
+      }
+
+      //plain columns outside the group by show the value of a group's first row
+      StringList theGroupBy = aQuery->getGroupBy();
+      StringList theCarried;
+      StringList theColumns = aQuery->getSelects();
+      for (auto& field : aQuery->getOrderBy())
+          theColumns.push_back(field);
+      for (auto& field : theColumns) {
+          if (!theOutputs.count(field) && std::find(theGroupBy.begin(), theGroupBy.end(), field) == theGroupBy.end()
+              && std::find(theCarried.begin(), theCarried.end(), field) == theCarried.end()) {
+              theCarried.push_back(field);
+              theInputs.push_back(field);
+          }
+      }
+
+      //the input scan only decodes what the aggregation reads
+      std::shared_ptr<Query> theInput = std::make_shared<Query>(*aQuery);
+      theInput->clearWindow();
+      theInput->setSelect(theInputs);
+
+      std::string theDetail;
+      for (auto& field : theGroupBy)
+          theDetail += (theDetail.size() ? ", " : "group by ") + field;
+      WindowSteps theWindowSteps(plan, *aQuery);
+      PlanScope theStep(plan, "hash aggregate", theDetail.size() ? theDetail : "one group");
+
+      HashAggregator theAggregator(theGroupBy, aQuery->getAggregates(), theCarried);
+      StatusResult theResult{ Errors::noError };
+      auto theAdd = [&](std::unique_ptr<Row> aRow) {
+          return bool(theResult = theAggregator.add(std::move(aRow)));
+      };
+
+      if (aJoins.size()) {
+          RowCollection theRows;
+          if (!(theResult = selectJoinRows(theInput, aJoins, theRows)))
+              return theResult;
+          for (auto& row : theRows) {
+              if (!theAdd(std::move(row)))
+                  break;
+          }
+      }
+      else {
+          StatusResult theScan = eachRow(theInput, theAdd);
+          if (!theScan)
+              return theScan;
+      }
+      if (!theResult)
+          return theResult;
+      if (theAggregator.getPartitionCount())
+          theStep.addDetail(", " + std::to_string(theAggregator.getPartitionCount()) + " partitions on disk");
+
+      RowCollection theGroups;
+      theResult = theAggregator.each([&theGroups](std::unique_ptr<Row> aRow) {
+          theGroups.push_back(std::move(aRow));
+          return true;
+          });
+      if (!theResult)
+          return theResult;
+      theStep.setRows(theGroups.size());
+
+      applyWindow(aQuery, theGroups, theWindowSteps);
+      for (auto& row : theGroups)
+          aRows.push_back(std::move(row));
+      return StatusResult{ Errors::noError };
+  }
+
+  StatusResult Database::findRows(std::shared_ptr<Query> aQuery, RowCollection& aRows) {
+      Index* theIndex = findIndex(aQuery->getFrom()->getName(), getPrimaryKey(aQuery));
+      if (!theIndex)
+          return StatusResult{ Errors::unknownIndex };
+
+      return scanRows(*theIndex, aQuery, planScan(aQuery, *theIndex), true, nullptr,
+          [&aRows](std::unique_ptr<Row> aRow) {
+              aRows.push_back(std::move(aRow));
+              return true;
+          });
+  }
+
+  StatusResult Database::upsertRows(std::string aTableName, const std::vector<std::string>& anAttNames,
+      const std::vector<std::vector<std::string>>& aValues, const std::vector<Assignment>& anUpdates) {
+      Entity* theTable = getEntity(aTableName);
+      if (!theTable)
+          return StatusResult{ Errors::unknownTable };
+      Attribute* theKeyAtt = theTable->getPrimaryKey();
+      Index* thePrimary = findIndex(aTableName, theKeyAtt->getName());
+      if (!thePrimary)
+          return StatusResult{ Errors::unknownIndex };
+
+      //the updates may not move a row to another key; their values are
+      //typed like a row, VALUES(field) is taken from each row
+      std::vector<std::string> theNames;
+      std::vector<std::vector<std::string>> theTexts(1);
+      for (auto& theUpdate : anUpdates) {
+          Attribute* theAtt = theTable->getAttribute(theUpdate.field);
+          if (!theAtt || (theUpdate.fromRow && !theTable->getAttribute(theUpdate.value)))
+              return StatusResult{ Errors::unknownAttribute };
+          if (theAtt->isPrimaryKey())
+              return StatusResult{ Errors::invalidAttribute };
+          if (!theUpdate.fromRow) {
+              theNames.push_back(theUpdate.field);
+              theTexts[0].push_back(theUpdate.value);
+          }
+      }
+      std::vector<KeyValues> theLiterals(1);
+      if (!theNames.empty())
+          buildKeyValueList(theLiterals, theTable, theNames, theTexts);
+
+      std::vector<KeyValues> theRows(aValues.size());
+      buildKeyValueList(theRows, theTable, anAttNames, aValues);
+
+      //one probe of the primary index per row: a key the table holds gets
+      //the updates, a key an earlier row of the list brought in updates that
+      //row, and any other row is inserted
+      std::vector<KeyValues> theInserts;
+      std::map<IndexKey, size_t> thePending;
+      std::map<IndexKey, KeyValues> theChanges;
+      for (auto& row : theRows) {
+          auto theValue = row.find(theKeyAtt->getName());
+          if (theValue == row.end()) {
+              theInserts.push_back(std::move(row));
+              continue;
+          }
+          IndexKey theKey;
+          if (!toIndexKey(theValue->second, thePrimary->getType(), theKey))
+              return StatusResult{ Errors::keyValueMismatch };
+
+          KeyValues theSet = theLiterals[0];
+          for (auto& theUpdate : anUpdates) {
+              auto theField = row.find(theUpdate.value);
+              if (theUpdate.fromRow && theField != row.end())
+                  theSet[theUpdate.field] = theField->second;
+          }
+
+          auto theInsert = thePending.find(theKey);
+          if (theInsert != thePending.end()) {
+              for (auto& theField : theSet)
+                  theInserts[theInsert->second][theField.first] = theField.second;
+          }
+          else if (thePrimary->exists(theKey)) {
+              KeyValues& theChange = theChanges[theKey];
+              for (auto& theField : theSet)
+                  theChange[theField.first] = theField.second;
+          }
+          else {
+              //a given key is reserved before any row draws a new one
+              if (auto* theNumber = std::get_if<uint32_t>(&theKey); theNumber && theKeyAtt->isAutoIncrement())
+                  theTable->reserveIncrement(*theNumber);
+              thePending[theKey] = theInserts.size();
+              theInserts.push_back(std::move(row));
+          }
+      }
+
+      //rows that already hold the new values are left alone
+      uint32_t theCount = 0;
+      auto theId = theTable->hashName(); //reference ID of the entity
+      Block theBlock;
+      for (auto& theChange : theChanges) {
+          IndexKey theKey = theChange.first;
+          uint32_t theBlockNum = *thePrimary->valueAt(theKey);
+          StatusResult theResult = storage.readBlock(theBlockNum, theBlock);
+          if (!theResult)
+              return theResult;
+          std::unique_ptr<Row> row = decodeRow(storage, theBlock, nullptr, *theTable);
+          if (!row->update(theChange.second))
+              continue;
+
+          std::stringstream news; //a new stream
+          row->encode(news);
+          StorageInfo theInfo(theId, news.str().size(), theBlockNum, BlockType::data_block, row->getID());
+          if (!(theResult = storage.save(news, theInfo)))
+              return theResult;
+          ++theCount;
+      }
+      changed = changed || theCount;
+
+      if (theInserts.empty())
+          return StatusResult{ Errors::noError, theCount };
+      StatusResult theResult = insertKeyValues(*theTable, theInserts, true);
+      theResult.value += theCount;
+      return theResult;
+  }
 
+  StatusResult Database::updateRows(std::shared_ptr<Query> aQuery, KeyValues& anUpdates) {
+      if (!aQuery || !aQuery->getFrom())
+          return StatusResult{ Errors::unknownCommand };
+
+      //the rows are found first, so that none is visited after its update
+      RowCollection theRows;
+      StatusResult theResult = findRows(aQuery, theRows);
+      if (!theResult)
+          return theResult;
+
+      //the indexes of the table on a field the update sets
+      Entity& theEntity = *aQuery->getFrom();
+      std::vector<Index*> theIndexes;
       for (auto& index : indexes) {
-          if (index.getTableName() == aQuery->getFrom()->getName() && index.getFieldName() == primaryKey) {
-              index.each([&](const Block& theBlock, uint32_t blockIndex)->bool {
-                  //read and decode row data
-                  std::stringstream ss;
-                  ss.write(theBlock.payload, theBlock.header.size);
-                  std::unique_ptr<Row> row = std::make_unique<Row>();
-                  row->decode(ss);
-
-                  //update row data if matches the query
-                  if (aQuery->matches(row->getData())) {
-                      ++count;
-
-                      //update and encode
-                      std::stringstream news; //a new stream
-                      row->update(anUpdates);
-                      row->encode(news);
-
-                      //prepare for a new block
-                      Block newBlock = theBlock;
-                      newBlock.header.size = news.str().size();
-                      news.read(newBlock.payload, newBlock.header.size);
-
-                      //overwrite data
-                      storage.writeBlock(blockIndex, newBlock);
-                  }
-                  return true;
-                  }
-              );
-              break;
+          if (index.getTableName() == theEntity.getName() && anUpdates.count(index.getFieldName()))
+              theIndexes.push_back(&index);
+      }
+
+      //rows that already hold the new values are left alone
+      std::vector<std::vector<IndexKey>> theOldKeys(theIndexes.size());
+      RowCollection theChanged;
+      for (auto& row : theRows) {
+          KeyValues& theData = row->getData();
+          std::vector<IndexKey> theKeys(theIndexes.size());
+          for (size_t i = 0; i < theIndexes.size(); ++i) {
+              auto theValue = theData.find(theIndexes[i]->getFieldName());
+              if (theValue != theData.end())
+                  toIndexKey(theValue->second, theIndexes[i]->getType(), theKeys[i]);
           }
+          if (!row->update(anUpdates))
+              continue;
+          for (size_t i = 0; i < theIndexes.size(); ++i)
+              theOldKeys[i].push_back(theKeys[i]);
+          theChanged.push_back(std::move(row));
+      }
+
+      //SET gives every row the same value, so an indexed field can only
+      //change in one row, and only to a key no other row holds
+      std::vector<IndexKey> theNewKeys(theIndexes.size());
+      for (size_t i = 0; i < theIndexes.size(); ++i) {
+          if (!toIndexKey(anUpdates[theIndexes[i]->getFieldName()], theIndexes[i]->getType(), theNewKeys[i]))
+              return StatusResult{ Errors::keyValueMismatch };
+          if (theChanged.size() > 1 || (theChanged.size() && theOldKeys[i][0] != theNewKeys[i]
+              && theIndexes[i]->exists(theNewKeys[i])))
+              return StatusResult{ Errors::duplicateKey };
+      }
+
+      auto theId = theEntity.hashName(); //reference ID of the entity
+      for (auto& row : theChanged) {
+          //a row that outgrows its blocks chains more, one that shrinks frees
+          //the rest; its first block stays, so the index entries still hold
+          std::stringstream news; //a new stream
+          row->encode(news);
+          StorageInfo theInfo(theId, news.str().size(), row->getBlockNum(), BlockType::data_block, row->getID());
+          theResult = storage.save(news, theInfo);
+          if (!theResult)
+              return theResult;
+      }
+
+      //move the index entries to the new keys
+      std::string primaryKey = getPrimaryKey(aQuery);
+      for (size_t i = 0; i < theIndexes.size() && theChanged.size(); ++i) {
+          theIndexes[i]->erase(theOldKeys[i][0]);
+          theIndexes[i]->setKeyValue(theNewKeys[i], theChanged[0]->getBlockNum());
+          auto* theKey = std::get_if<uint32_t>(&theNewKeys[i]);
+          if (theKey && theIndexes[i]->getFieldName() == primaryKey)
+              theEntity.reserveIncrement(*theKey);
       }
       changed = true;
-      return StatusResult{ Errors::noError, count };
+      return StatusResult{ Errors::noError, uint32_t(theChanged.size()) };
   }
 
   StatusResult Database::deleteRows(std::shared_ptr<Query> aQuery) {
-      if (!aQuery)
+      if (!aQuery || !aQuery->getFrom())
           return StatusResult{ Errors::unknownCommand };
 
-      auto theId = aQuery->getFrom()->hashName(); //reference ID of the entity
-      uint32_t count = 0;
-
-      std::string primaryKey = getPrimaryKey(aQuery);
-      std::vector<Row*> toBeDelete;
+      Entity& theEntity = *aQuery->getFrom();
+      Index* thePrimary = findIndex(theEntity.getName(), getPrimaryKey(aQuery));
+      if (!thePrimary)
+          return StatusResult{ Errors::unknownIndex };
 
+      //rows only decode what the filters and the indexes of the table need
+      std::vector<Index*> tableIndexes;
       for (auto& index : indexes) {
-          if (index.getTableName() == aQuery->getFrom()->getName() && index.getFieldName() == primaryKey) {
-              index.each([&](const Block& theBlock, uint32_t blockIndex)->bool {
-                  //read and decode row data
-                  std::stringstream ss;
-                  ss.write(theBlock.payload, theBlock.header.size);
-                  Row* theRow = new Row{};
-                  theRow->decode(ss);
-                  if (aQuery->matches(theRow->getData()))
-                      toBeDelete.push_back(theRow);
+          if (index.getTableName() == theEntity.getName())
+              tableIndexes.push_back(&index);
+      }
+      StringSet theFields;
+      const StringSet* theProjection = nullptr;
+      if (aQuery->getProjection(theFields)) {
+          for (auto* index : tableIndexes)
+              theFields.insert(index->getFieldName());
+          theProjection = &theFields;
+      }
 
-                  return true;
-                  }
-              );
+      //one pass over the planned range collects the blocks and index keys
+      //of the matching rows, nothing changes until it is done
+      std::vector<uint32_t> theBlocks;
+      std::vector<std::vector<IndexKey>> theKeys(tableIndexes.size());
+      std::vector<uint32_t> theChain;
+      uint32_t theCount = 0;
+      thePrimary->each(planScan(aQuery, *thePrimary).range, [&](const Block& theBlock, uint32_t blockIndex)->bool {
+          //the blocks of a chained row are noted while it is decoded
+          theChain.clear();
+          std::unique_ptr<Row> row = decodeRow(storage, theBlock, theProjection, theEntity, &theChain);
+          KeyValues& theData = row->getData();
+          if (!aQuery->matches(theData))
+              return true;
+
+          ++theCount;
+          theBlocks.push_back(blockIndex);
+          theBlocks.insert(theBlocks.end(), theChain.begin(), theChain.end());
+
+          IndexKey theKey;
+          for (size_t i = 0; i < tableIndexes.size(); ++i) {
+              auto theValue = theData.find(tableIndexes[i]->getFieldName());
+              if (theValue != theData.end() && toIndexKey(theValue->second, tableIndexes[i]->getType(), theKey))
+                  theKeys[i].push_back(theKey);
+          }
+          return true;
+          }, true);
+
+      //index entries go in key order, the blocks in one batch of runs
+      for (size_t i = 0; i < tableIndexes.size(); ++i) {
+          std::sort(theKeys[i].begin(), theKeys[i].end());
+          tableIndexes[i]->eraseSorted(theKeys[i]);
+      }
+      StatusResult theResult = storage.freeBlocks(theBlocks);
+      theEntity.removeRows(theCount);
+
+      changed = true;
+      return StatusResult{ theResult.error, theCount };
+  }
+
+  //the schema version a row was written under, read from the start of its
+  //first block ("blockNum@version ") without decoding the row
+  static uint32_t rowVersion(const Block& aBlock) {
+      const char* theEnd = aBlock.payload + std::min<size_t>(aBlock.header.size, kPayloadSize);
+      const char* theSpace = std::find(aBlock.payload, theEnd, ' ');
+      const char* theAt = std::find(aBlock.payload, theSpace, '@');
+      uint32_t theVersion = 0;
+      for (const char* p = theAt + 1; p < theSpace && std::isdigit(*p); ++p)
+          theVersion = theVersion * 10 + (*p - '0');
+      return theVersion;
+  }
+
+  //blocks read per run while vacuum collects the headers of the file
+  const size_t kVacuumBatch = 256;
+
+  StatusResult Database::vacuum(const std::string& aTableName, size_t aLimit) {
+      if (!aTableName.empty() && !tables.count(aTableName))
+          return StatusResult{ Errors::unknownTable };
+
+      //the schema version of each table by the refId of its blocks
+      std::map<uint32_t, uint32_t> theVersions;
+      for (auto& entity : entities)
+          theVersions[entity.hashName()] = entity.getVersion();
+
+      //one pass reads every header, so chains are followed in memory; rows
+      //of an older schema are noted on the way
+      uint32_t theCount = storage.getBlockCount();
+      std::vector<BlockHeader> theHeaders(theCount);
+      std::set<uint32_t> theStale;
+      std::vector<Block> theRun(kVacuumBatch);
+      for (uint32_t theStart = 0; theStart < theCount; theStart += kVacuumBatch) {
+          size_t theSize = std::min<size_t>(kVacuumBatch, theCount - theStart);
+          StatusResult theResult = storage.readBlocks(theStart, theRun.data(), theSize);
+          if (!theResult)
+              return theResult;
+          for (size_t i = 0; i < theSize; ++i) {
+              const BlockHeader& theHeader = theHeaders[theStart + i] = theRun[i].header;
+              auto theVersion = theVersions.find(theHeader.refId);
+              if (theHeader.type == char(BlockType::data_block) && theHeader.pos == 0
+                  && theVersion != theVersions.end() && rowVersion(theRun[i]) < theVersion->second)
+                  theStale.insert(theStart + uint32_t(i));
+          }
+      }
+
+      //the same links Storage::getChain follows
+      auto theChainOf = [&](uint32_t aHead) {
+          std::vector<uint32_t> theChain{ aHead };
+          const BlockHeader& theFirst = theHeaders[aHead];
+          uint32_t theNext = theFirst.next;
+          while (theNext && theNext < theCount && theChain.size() < theCount
+              && theHeaders[theNext].type == theFirst.type && theHeaders[theNext].refId == theFirst.refId
+              && theHeaders[theNext].pos == uint8_t(theChain.size() + theFirst.pos)) {
+              theChain.push_back(theNext);
+              theNext = theHeaders[theNext].next;
+          }
+          return theChain;
+      };
+
+      //what the catalog and the primary indexes reach is live, the rest is free
+      std::vector<bool> theLive(theCount, false);
+      auto theMark = [&](uint32_t aHead) {
+          if (aHead >= theCount)
+              return uint32_t(0);
+          auto theChain = theChainOf(aHead);
+          for (auto theBlock : theChain)
+              theLive[theBlock] = true;
+          return *std::max_element(theChain.begin(), theChain.end());
+      };
+      theMark(0);
+      for (auto& table : tables)
+          theMark(table.second);
+      for (auto& index : indexes)
+          theMark(index.getBlockNum());
+
+      //the rows to look at: last block, first block, table
+      std::vector<std::tuple<uint32_t, uint32_t, Entity*>> theRows;
+      for (auto& entity : entities) {
+          if (entity.getStatsBlock())
+              theMark(entity.getStatsBlock());
+          Index* thePrimary = findIndex(entity.getName(), entity.getPrimaryKey()->getName());
+          if (!thePrimary)
+              continue;
+          bool inScope = aTableName.empty() || entity.getName() == aTableName;
+          thePrimary->eachKV([&](const IndexKey&, uint32_t aBlockNum) {
+              uint32_t theLast = theMark(aBlockNum);
+              if (inScope && aBlockNum < theCount)
+                  theRows.emplace_back(theLast, aBlockNum, &entity);
+              return true;
+              });
+      }
+
+      std::vector<uint32_t> theFree, theUnmarked;
+      for (uint32_t theBlock = 0; theBlock < theCount; ++theBlock) {
+          if (theLive[theBlock])
+              continue;
+          theFree.push_back(theBlock);
+          if (theHeaders[theBlock].type != char(BlockType::free_block))
+              theUnmarked.push_back(theBlock);
+      }
+      storage.setFreeBlocks(theFree);
+      StatusResult theResult = storage.freeBlocks(theUnmarked);
+      if (!theResult)
+          return theResult;
+
+      //rows past the size the live blocks need, or with their chain apart,
+      //move to the first free run before them, starting from the end of
+      //the file; a row of an older schema is written in the current one
+      uint32_t theTarget = theCount - uint32_t(theFree.size());
+      std::sort(theRows.rbegin(), theRows.rend());
+      uint32_t theMoved = 0;
+      for (auto& [theLast, theHead, theEntity] : theRows) {
+          if (aLimit && theMoved >= aLimit)
               break;
+          auto theOld = theChainOf(theHead);
+          bool isApart = theOld.back() - theOld.front() + 1 != theOld.size();
+          bool isStale = theStale.count(theHead);
+          if (theLast < theTarget && !isApart && !isStale)
+              continue;
+
+          Block theFirst;
+          if (!(theResult = storage.readBlock(theHead, theFirst)))
+              return theResult;
+          std::unique_ptr<Row> theRow = decodeRow(storage, theFirst, nullptr, *theEntity);
+          std::stringstream ss;
+          Row(theRow->getData(), theHead, theEntity->getVersion()).encode(ss);
+          size_t theUsed = std::max<size_t>((ss.str().size() + kPayloadSize - 1) / kPayloadSize, 1);
+
+          //the block number is part of the row, so the row is encoded again
+          //for the run it gets; when the longer number needs more blocks,
+          //the run goes back and a longer one is taken
+          std::vector<uint32_t> theNew;
+          std::string theData;
+          while (!(theNew = storage.getFreeRun(theUsed, theLast)).empty()) {
+              std::stringstream theMovedRow;
+              Row(theRow->getData(), theNew.front(), theEntity->getVersion()).encode(theMovedRow);
+              theData = theMovedRow.str();
+              theUsed = std::max<size_t>((theData.size() + kPayloadSize - 1) / kPayloadSize, 1);
+              if (theUsed <= theNew.size())
+                  break;
+              storage.returnBlocks(theNew);
           }
+          if (theNew.empty()) {
+              if (isStale) {
+                  //no better place, the row is rewritten where it is
+                  StorageInfo theInfo(theEntity->hashName(), ss.str().size(), theHead,
+                      BlockType::data_block, theFirst.header.id);
+                  if (!(theResult = storage.save(ss, theInfo)))
+                      return theResult;
+                  ++theMoved;
+              }
+              continue;
+          }
+
+          //a shorter number may leave the last block of the run unused
+          std::vector<uint32_t> theExtra(theNew.begin() + theUsed, theNew.end());
+          theNew.resize(theUsed);
+          std::vector<Block> theBlocks(theUsed, Block(BlockType::data_block));
+          for (size_t pos = 0; pos < theUsed; ++pos) {
+              BlockHeader& theHeader = theBlocks[pos].header;
+              theHeader.pos = pos;
+              theHeader.count = theUsed;
+              theHeader.next = pos + 1 < theUsed ? theNew[pos + 1] : 0;
+              theHeader.refId = theEntity->hashName();
+              theHeader.id = theFirst.header.id;
+              theHeader.size = std::min(kPayloadSize, theData.size() - pos * kPayloadSize);
+              std::copy_n(theData.data() + pos * kPayloadSize, theHeader.size, theBlocks[pos].payload);
+          }
+          if (!(theResult = storage.writeBlocks(theNew.front(), theBlocks.data(), theUsed)))
+              return theResult;
+
+          //the index entries follow the row, then its old blocks are freed
+          KeyValues& theFields = theRow->getData();
+          for (auto& index : indexes) {
+              if (index.getTableName() != theEntity->getName())
+                  continue;
+              IndexKey theKey;
+              auto theValue = theFields.find(index.getFieldName());
+              if (theValue != theFields.end() && toIndexKey(theValue->second, index.getType(), theKey)
+                  && index.valueAt(theKey) == theHead)
+                  index.setKeyValue(theKey, theNew.front());
+          }
+          storage.returnBlocks(theExtra);
+          if (!(theResult = storage.freeBlocks(theOld)))
+              return theResult;
+          ++theMoved;
       }
 
-      for (auto* row : toBeDelete) {
-          deleteIndexes(row->getData());
-          storage.markBlockAsFree(row->getBlockNum());
-          delete row;
+      //the catalog is written again into the lowest free blocks: indexes,
+      //entities and statistics of the tables vacuumed, then the meta block
+      auto theRewrite = [&](uint32_t aHead, Storable& anItem, StorageInfo anInfo) {
+          auto theChain = storage.getChain(aHead);
+          if (aHead)
+              storage.freeBlocks(theChain);
+          else
+              storage.freeBlocks(std::vector<uint32_t>(theChain.begin() + 1, theChain.end()));
+          std::stringstream ss;
+          anItem.encode(ss);
+          anInfo.size = ss.str().size();
+          anInfo.start = aHead ? kNewBlock : 0;
+          uint32_t theNewHead = aHead ? storage.getNextFreeBlockNum() : 0;
+          storage.save(ss, anInfo);
+          return theNewHead;
+      };
+      for (auto& index : indexes) {
+          if (!aTableName.empty() && index.getTableName() != aTableName)
+              continue;
+          indexBlockNums.erase(index.getBlockNum());
+          index.setBlockNum(theRewrite(index.getBlockNum(), index, index.getStorageInfo(0)));
+          indexBlockNums.insert(index.getBlockNum());
+          index.setChanged(false);
+      }
+      for (auto& entity : entities) {
+          if (!aTableName.empty() && entity.getName() != aTableName)
+              continue;
+          tables[entity.getName()] = theRewrite(tables[entity.getName()], entity,
+              StorageInfo(entity.hashName(), 0, kNewBlock, BlockType::entity_block));
+          if (entity.getStatsBlock() && statistics.count(entity.getName()))
+              entity.setStatsBlock(theRewrite(entity.getStatsBlock(), statistics[entity.getName()],
+                  StorageInfo(entity.hashName(), 0, kNewBlock, BlockType::stats_block)));
+      }
+      theRewrite(0, *this, StorageInfo(0, 0, 0, BlockType::meta_block));
+
+      //the free blocks at the end leave the file
+      uint32_t theKeep = storage.trimFreeBlocks();
+      if (theKeep < storage.getBlockCount()) {
+          stream.flush();
+          std::error_code theError;
+          std::filesystem::resize_file(Config::getDBPath(name), uint64_t(theKeep) * sizeof(Block), theError);
+          if (theError)
+              return StatusResult{ Errors::writeError };
       }
 
       changed = true;
-      return StatusResult{ Errors::noError, toBeDelete.size() };
+      return StatusResult{ Errors::noError, theMoved };
   }
 
   std::unique_ptr<std::vector<BlockHeader>> Database::debugDump() {
@@ -21,9 +21,22 @@
 #include "Query.hpp"
 #include "Index.hpp"
 #include "Join.hpp"
+#include "Scheduler.hpp"
+#include "Plan.hpp"
+#include "Planner.hpp"
+#include "Loader.hpp"
+#include "Exporter.hpp"
 
 namespace ECE141 {
 
+  //one SET of ON DUPLICATE KEY UPDATE: the text of a value, or with fromRow
+  //the value the inserted row holds for the field named by value
+  struct Assignment {
+    std::string field;
+    std::string value;
+    bool        fromRow;
+  };
+
   class Database : public Storable {
   public:
     
@@ -33,6 +46,9 @@ namespace ECE141 {
 
     std::string getName() { return this->name; }
 
+    //workers the parallel operators submit their morsels to
+    void setScheduler(Scheduler* aScheduler) { scheduler = aScheduler; }
+
     //get certain entity
     Entity* getEntity(std::string aName);
 
@@ -45,23 +61,57 @@ namespace ECE141 {
     //get pair(table / field) of all indexes
     IndexPairs getAllIndexes();
 
-    void deleteIndexes(KeyValues& aKeyValue);
+    //index on a table field, nullptr if the field is not indexed
+    Index* findIndex(const std::string& aTableName, const std::string& aFieldName);
+
     void deleteAllIndexes(std::string aTableName);
-    void insertIndexes(std::vector<Index*> anIndexes, KeyValues& aKeyValue, uint32_t blockNum);
 
     StatusResult addTable(std::string aName, const std::vector<Attribute>& anAttributes);
     StatusResult dropTable(std::string aName);
+    //remove every row of a table, keeping its schema, indexes and increment
+    StatusResult truncateTable(std::string aName);
     StatusResult alterTable(std::string aTableName, Keywords aMode, Attribute& anAtt);
     
     std::string getPrimaryKey(std::shared_ptr<Query> aQuery);
 
-    std::shared_ptr<Query> buildQuery(Join& aJoin, Value aValue);
+    //what the planner estimates with: the analyzed statistics of a table,
+    //its current row count and the primary key range of its index
+    TableStats getTableStats(Entity& anEntity);
+
+    //collect column statistics and store them in the catalog
+    StatusResult analyzeTable(const std::string& aTableName);
 
     StatusResult insertRows(std::string aTableName, const std::vector<std::string>& anAttNames, const std::vector<std::vector<std::string>>& aValues);
+    //insert the rows whose primary key the table does not hold yet, and
+    //apply anUpdates to the rows that hold it; the value of the result is
+    //the number of rows inserted or changed
+    StatusResult upsertRows(std::string aTableName, const std::vector<std::string>& anAttNames,
+        const std::vector<std::vector<std::string>>& aValues, const std::vector<Assignment>& anUpdates);
+    //insert the records of a CSV or JSON-lines file; chunks of the file are
+    //parsed on the scheduler and written in file order, a failed result
+    //holds the line of the bad record
+    StatusResult loadRows(const std::string& aTableName, const std::string& aPath, LoadFormat aFormat);
+    //write the rows of a select to a file as the executor produces them,
+    //the value of the result is the number of rows written
+    StatusResult exportRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins,
+        const std::string& aPath, ExportFormat aFormat);
+    //run a select through the aggregate, join or single table path
+    StatusResult queryRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins, RowCollection& aRows);
+    //record the operators of a select in aPlan, running it only for EXPLAIN ANALYZE
+    StatusResult explainRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins, QueryPlan& aPlan);
     StatusResult selectRows(std::shared_ptr<Query> aQuery, RowCollection& aRows);
+    //stream the rows of a single table query to aVisitor in final order
+    StatusResult eachRow(std::shared_ptr<Query> aQuery, const RowVisitor& aVisitor);
     StatusResult selectJoinRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins, RowCollection& aRows);
+    //one row per group with the aggregates of the query
+    StatusResult aggregateRows(std::shared_ptr<Query> aQuery, std::vector<Join> aJoins, RowCollection& aRows);
     StatusResult updateRows(std::shared_ptr<Query> aQuery, KeyValues& anUpdates);
     StatusResult deleteRows(std::shared_ptr<Query> aQuery);
+    //move the rows of a table (all tables when aTableName is empty) into the
+    //free blocks nearest the front of the file and cut the free blocks off
+    //its end; at most aLimit rows when it is not 0, so a large file can be
+    //compacted in steps. The value of the result is the rows moved
+    StatusResult vacuum(const std::string& aTableName, size_t aLimit);
     
     std::unique_ptr<std::vector<BlockHeader>> debugDump();
 
@@ -71,7 +121,37 @@ namespace ECE141 {
     /*----------------Storable----------------*/
 
   private:
-      StatusResult alterRow(Attribute& anAtt, Keywords aMode, std::string aTableName, std::string aPrimaryKey);      
+      //answer an aggregate query from row counts and index ends, false
+      //when it needs a scan
+      bool aggregateFromMetadata(std::shared_ptr<Query> aQuery, RowCollection& aRows);
+
+      //read the rows of the given keys through an index, in key order
+      StatusResult probeRows(Index& anIndex, const std::set<IndexKey>& aKeys,
+          const StringSet* aProjection, RowCollection& aRows);
+
+      //visit the rows of the planned key range that pass the query filters in
+      //index order, large ranges are split into morsels read by the scan threads
+      StatusResult scanRows(Index& anIndex, std::shared_ptr<Query> aQuery, const ScanPlan& aScan,
+          bool anAscending, const StringSet* aProjection, const RowVisitor& aVisitor);
+
+      //full scan or key range of a table's primary key index for the query filters
+      ScanPlan planScan(std::shared_ptr<Query> aQuery, Index& anIndex);
+
+      //whole rows of the query's table that pass its filters, found through
+      //the access path a select would take: a key, a key range or a full scan
+      StatusResult findRows(std::shared_ptr<Query> aQuery, RowCollection& aRows);
+
+      //an input of aRows rows joined on aField, as the planner sees it
+      JoinInput joinInput(const TableField& aField, double aRows);
+
+      //inner joins go smallest result first, as long as each finds its left table
+      std::vector<Join> orderJoins(std::shared_ptr<Query> aQuery, const std::vector<Join>& aJoins, double aLeftRows);
+
+      //write new rows of a table: their blocks are taken in one go and filled
+      //in block order, the index entries are added sorted by key; with
+      //aKeepIds a row that holds an id keeps it instead of a new one
+      StatusResult insertKeyValues(Entity& anEntity, std::vector<KeyValues>& aRows, bool aKeepIds = false);
+
 
   protected:    
     std::string         name;
@@ -84,6 +164,11 @@ namespace ECE141 {
 
     std::set<uint32_t>  indexBlockNums; //block number of index blocks
     std::vector<Index>  indexes; //vector of indexes
+
+    std::map<std::string, TableStats> statistics; //key: table name, from ANALYZE TABLE
+
+    Scheduler*          scheduler; //shared workers, scans run serially without one
+    QueryPlan*          plan; //operators record themselves here while a select is explained
   };
 
 }
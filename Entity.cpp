@@ -26,20 +26,29 @@ namespace ECE141 {
   }
   
   Entity::Entity(std::string aName, const AttributeList& anAttList)
-      : name(aName), attributes(anAttList), increment(1) {}
+      : name(aName), attributes(anAttList), increment(1), rowCount(0), statsBlock(0), version(0) {}
 
   Entity::Entity(const Entity& aCopy)
-      : name(aCopy.name), attributes(aCopy.attributes), increment(aCopy.increment) {}
+      : name(aCopy.name), attributes(aCopy.attributes), increment(aCopy.increment),
+      rowCount(aCopy.rowCount), statsBlock(aCopy.statsBlock), version(aCopy.version) {}
 
   Entity& Entity::operator=(const Entity* aCopy) {
       this->attributes = aCopy->attributes;
       this->name = aCopy->name;
+      this->increment = aCopy->increment;
+      this->rowCount = aCopy->rowCount;
+      this->statsBlock = aCopy->statsBlock;
+      this->version = aCopy->version;
       return *this;
   }
 
   Entity& Entity::operator=(const Entity& aCopy) {
       this->attributes = aCopy.attributes;
       this->name = aCopy.name;
+      this->increment = aCopy.increment;
+      this->rowCount = aCopy.rowCount;
+      this->statsBlock = aCopy.statsBlock;
+      this->version = aCopy.version;
       return *this;
   }
 
@@ -53,6 +62,10 @@ namespace ECE141 {
   }
 
   StatusResult Entity::addAttribute(Attribute& anAtt) {
+      if (getAttribute(anAtt.getName()))
+          return StatusResult{ Errors::invalidAttribute };
+
+      anAtt.setVersion(++version);
       attributes.push_back(anAtt);
       return StatusResult{ Errors::noError };
   }
@@ -60,7 +73,10 @@ namespace ECE141 {
   StatusResult Entity::dropAttribute(Attribute& anAtt) {
       for (int i = 0; i < attributes.size(); ++i) {
           if (attributes[i].getName() == anAtt.getName()) {
+              if (attributes[i].isPrimaryKey())
+                  return StatusResult{ Errors::invalidAttribute };
               attributes.erase(attributes.begin() + i);
+              ++version;
               return StatusResult{ Errors::noError };
           }
       }
@@ -68,6 +84,24 @@ namespace ECE141 {
       return StatusResult{ Errors::unknownAttribute };
   }
 
+  void Entity::upgrade(KeyValues& aData, uint32_t aVersion, const StringSet* aFields) {
+      //a value stored under a column that was dropped, or dropped and added
+      //again, is not a value of the current column; every row keeps its id
+      for (auto theField = aData.begin(); theField != aData.end(); ) {
+          Attribute* theAtt = getAttribute(theField->first);
+          if (theAtt ? theAtt->getVersion() > aVersion : theField->first != "id")
+              theField = aData.erase(theField);
+          else
+              ++theField;
+      }
+
+      for (auto& att : attributes) {
+          if (att.getVersion() > aVersion && att.hasDefaultValue()
+              && (!aFields || aFields->count(att.getName())))
+              aData[att.getName()] = att.getDefaultValue();
+      }
+  }
+
   StatusResult Entity::encode(std::ostream &aWriter) {
       aWriter << name << ' ' << increment << ' ';
 
@@ -77,6 +111,9 @@ namespace ECE141 {
       }
 
       aWriter << '#' << ' '; //an eof flag
+      aWriter << rowCount << ' ' << statsBlock << ' ' << version << ' ';
+      for (auto& attribute : attributes)
+          aWriter << attribute.getVersion() << ' ';
 
       return StatusResult{noError};
   }
@@ -98,6 +135,14 @@ namespace ECE141 {
           attributes.push_back(att);
       }
 
+      //older tables have no row count after the flag
+      aReader.get();
+      rowCount = (aReader >> temp) ? std::stoul(temp) : kUnknownCount;
+      statsBlock = (aReader >> temp) ? std::stoul(temp) : 0;
+      version = (aReader >> temp) ? std::stoul(temp) : 0;
+      for (auto& attribute : attributes)
+          attribute.setVersion((aReader >> temp) ? std::stoul(temp) : 0);
+
       return StatusResult{noError};
   }
 
@@ -14,6 +14,7 @@
 #include <optional>
 #include <memory>
 #include <string>
+#include <algorithm>
 
 #include "Attribute.hpp"
 #include "BasicTypes.hpp"
@@ -46,6 +47,29 @@ namespace ECE141 {
 
     uint32_t getIncrement() { return increment++; }   
 
+    //a key set by hand must not be handed out again
+    Entity&  reserveIncrement(uint32_t aKey) { increment = std::max(increment, aKey + 1); return *this; }
+
+    //exact number of rows, kept up to date by insert and delete
+    uint32_t getRowCount() const { return rowCount; }
+    bool     hasRowCount() const { return rowCount != kUnknownCount; }
+    Entity&  setRowCount(uint32_t aCount) { rowCount = aCount; return *this; }
+    Entity&  addRows(uint32_t aCount) { rowCount += aCount; return *this; }
+    Entity&  removeRows(uint32_t aCount) { rowCount -= std::min(aCount, rowCount); return *this; }
+
+    //first block of the statistics ANALYZE TABLE stored, 0 if never analyzed
+    uint32_t getStatsBlock() const { return statsBlock; }
+    Entity&  setStatsBlock(uint32_t aBlockNum) { statsBlock = aBlockNum; return *this; }
+
+    //schema version, moved on by every ALTER TABLE; rows record the version
+    //they were written under and are brought up to date as they are read
+    uint32_t getVersion() const { return version; }
+
+    //fix the fields of a row written under aVersion: columns dropped since
+    //are removed, columns added since take their default or stay null;
+    //only aFields are filled in when given
+    void     upgrade(KeyValues& aData, uint32_t aVersion, const StringSet* aFields);
+
     //get primary key attribute
     Attribute* getPrimaryKey();
 
@@ -71,9 +95,15 @@ namespace ECE141 {
 
   protected:
 
+    //row count of a table stored before counts were kept
+    static const uint32_t kUnknownCount = 0xFFFFFFFF;
+
     std::string   name;
     AttributeList attributes;
     uint32_t      increment;
+    uint32_t      rowCount;
+    uint32_t      statsBlock;
+    uint32_t      version;
   };
   
 }
@@ -58,6 +58,7 @@ namespace ECE141 {
     indexExists=600,
     cantCreateIndex=605,
     unknownIndex=610,
+    duplicateKey=615,
     
     //command related...
     unknownCommand=3000,
@@ -0,0 +1,146 @@
+//
+//  Exporter.cpp
+//
+//  Created by Yunhsiu Wu on 5/31/21.
+//
+
+#include <limits>
+#include <type_traits>
+#include <sstream>
+#include "Exporter.hpp"
+
+namespace ECE141 {
+
+    //text of a value as it reads back into its column
+    static std::string toText(const Value& aValue) {
+        std::ostringstream theText;
+        theText.precision(std::numeric_limits<double>::digits10);
+        std::visit([&theText](const auto& aData) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(aData)>, bool>)
+                theText << (aData ? "true" : "false");
+            else
+                theText << aData;
+            }, aValue);
+        return theText.str();
+    }
+
+    std::unique_ptr<RowWriter> RowWriter::create(ExportFormat aFormat, std::ostream& anOutput, const StringList& aColumns) {
+        if (aFormat == ExportFormat::binary)
+            return std::make_unique<ColumnarWriter>(anOutput, aColumns);
+        return std::make_unique<CSVWriter>(anOutput, aColumns);
+    }
+
+    CSVWriter::CSVWriter(std::ostream& anOutput, const StringList& aColumns)
+        : RowWriter(anOutput, aColumns) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (i)
+                output << ',';
+            writeText(columns[i]);
+        }
+        output << '\n';
+    }
+
+    void CSVWriter::writeText(const std::string& aText) {
+        //an empty text is quoted so that it does not read back as null
+        if (!aText.empty() && aText.find_first_of(",\"\r\n") == std::string::npos) {
+            output << aText;
+            return;
+        }
+        output << '"';
+        for (char theChar : aText) {
+            if (theChar == '"')
+                output << '"';
+            output << theChar;
+        }
+        output << '"';
+    }
+
+    void CSVWriter::write(const KeyValues& aRow) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (i)
+                output << ',';
+            auto theField = aRow.find(columns[i]);
+            if (theField == aRow.end())
+                continue;
+            if (auto* theText = std::get_if<std::string>(&theField->second))
+                writeText(*theText);
+            else
+                output << toText(theField->second);
+        }
+        output << '\n';
+    }
+
+    ColumnarWriter::ColumnarWriter(std::ostream& anOutput, const StringList& aColumns)
+        : RowWriter(anOutput, aColumns), group(aColumns.size()), rows(0) {
+        output.write("ECE141C1", 8);
+        writeRaw(uint32_t(columns.size()));
+        for (auto& theName : columns) {
+            writeRaw(uint32_t(theName.size()));
+            output.write(theName.data(), theName.size());
+        }
+        for (auto& theColumn : group)
+            theColumn.reserve(kGroupRows);
+    }
+
+    void ColumnarWriter::write(const KeyValues& aRow) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            auto theField = aRow.find(columns[i]);
+            group[i].push_back(theField == aRow.end() ? std::nullopt : std::optional<Value>(theField->second));
+        }
+        if (++rows == kGroupRows)
+            writeGroup();
+    }
+
+    void ColumnarWriter::finish() {
+        if (rows)
+            writeGroup();
+        writeRaw(uint32_t(0));
+    }
+
+    void ColumnarWriter::writeGroup() {
+        writeRaw(uint32_t(rows));
+        for (auto& theColumn : group) {
+            writeColumn(theColumn);
+            theColumn.clear();
+        }
+        rows = 0;
+    }
+
+    void ColumnarWriter::writeColumn(const std::vector<std::optional<Value>>& aValues) {
+        static const char theTypes[] = { 'b', 'i', 'd', 's' };
+
+        //the type of the present values, text when they disagree
+        std::optional<size_t> theType;
+        std::vector<uint8_t> theBitmap((aValues.size() + 7) / 8, 0);
+        for (size_t i = 0; i < aValues.size(); ++i) {
+            if (!aValues[i])
+                continue;
+            theBitmap[i / 8] |= uint8_t(1 << (i % 8));
+            if (!theType)
+                theType = aValues[i]->index();
+            else if (*theType != aValues[i]->index())
+                theType = 3;
+        }
+
+        output.put(theType ? theTypes[*theType] : 'n');
+        output.write(reinterpret_cast<const char*>(theBitmap.data()), theBitmap.size());
+        if (!theType)
+            return;
+
+        for (auto& theValue : aValues) {
+            if (!theValue)
+                continue;
+            switch (*theType) {
+            case 0: output.put(std::get<bool>(*theValue) ? 1 : 0); break;
+            case 1: writeRaw(int32_t(std::get<int>(*theValue))); break;
+            case 2: writeRaw(std::get<double>(*theValue)); break;
+            default: {
+                std::string theText = theValue->index() == 3 ? std::get<std::string>(*theValue) : toText(*theValue);
+                writeRaw(uint32_t(theText.size()));
+                output.write(theText.data(), theText.size());
+            }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,85 @@
+//
+//  Exporter.hpp
+//
+//  Created by Yunhsiu Wu on 5/31/21.
+//
+
+#ifndef Exporter_hpp
+#define Exporter_hpp
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <iostream>
+#include "BasicTypes.hpp"
+
+namespace ECE141 {
+
+    enum class ExportFormat { csv, binary };
+
+    //writes the rows of a query as they arrive, one field per column
+    class RowWriter {
+    public:
+        RowWriter(std::ostream& anOutput, const StringList& aColumns)
+            : output(anOutput), columns(aColumns) {}
+
+        virtual ~RowWriter() {}
+
+        virtual void    write(const KeyValues& aRow) = 0;
+
+        //write what is still held back
+        virtual void    finish() {}
+
+        static std::unique_ptr<RowWriter> create(ExportFormat aFormat, std::ostream& anOutput, const StringList& aColumns);
+
+    protected:
+        std::ostream&   output;
+        StringList      columns;
+    };
+
+    //a header line of column names, then one line per row; text is quoted
+    //when it holds a comma, a quote or a line break, a null field is empty
+    class CSVWriter : public RowWriter {
+    public:
+        CSVWriter(std::ostream& anOutput, const StringList& aColumns);
+
+        void    write(const KeyValues& aRow) override;
+
+    protected:
+        void    writeText(const std::string& aText);
+    };
+
+    //rows in groups, each group stored column by column:
+    //  file:   "ECE141C1", uint32 column count, each name as uint32 length + bytes,
+    //          the groups, and a uint32 0 in place of a row count at the end
+    //  group:  uint32 row count, then for every column a type letter (b, i, d, s,
+    //          or n when all are null), a bitmap with a bit set for each present
+    //          value, and the present values: bool 1 byte, int 4, double 8,
+    //          text as uint32 length + bytes
+    //numbers are written in the byte order of the machine
+    class ColumnarWriter : public RowWriter {
+    public:
+        static const size_t kGroupRows = 4096;
+
+        ColumnarWriter(std::ostream& anOutput, const StringList& aColumns);
+
+        void    write(const KeyValues& aRow) override;
+        void    finish() override;
+
+    protected:
+        void    writeGroup();
+        void    writeColumn(const std::vector<std::optional<Value>>& aValues);
+
+        template<typename T>
+        void    writeRaw(const T& aValue) {
+            output.write(reinterpret_cast<const char*>(&aValue), sizeof(T));
+        }
+
+        std::vector<std::vector<std::optional<Value>>> group; //values by column
+        size_t  rows;
+    };
+
+}
+
+#endif /* Exporter_hpp */
@@ -99,8 +99,10 @@ namespace ECE141 {
       theRHS=aList[rhs.name]; //get row value
     }
 
-    return comparitors.count(op)
-      ? comparitors[op](theLHS, theRHS) : false;
+    //find() leaves the shared table untouched, scans call this from many threads
+    auto theComparitor = comparitors.find(op);
+    return theComparitor != comparitors.end()
+      ? theComparitor->second(theLHS, theRHS) : false;
   }
 
   void Expression::addLogic(Operators anOp) {
@@ -125,6 +127,9 @@ namespace ECE141 {
   Filters::Filters()  {}
   
   Filters::Filters(const Filters &aCopy)  {
+    for(auto &theExpr : aCopy.expressions) {
+      expressions.push_back(std::make_unique<Expression>(*theExpr));
+    }
   }
   
   Filters::~Filters() {
@@ -222,6 +227,15 @@ namespace ECE141 {
       return *this;
   }
 
+  void Filters::collectFields(StringSet &aFields) const {
+      for (auto &theExpr : expressions) {
+          if (TokenType::identifier == theExpr->lhs.ttype)
+              aFields.insert(theExpr->lhs.name);
+          if (TokenType::identifier == theExpr->rhs.ttype)
+              aFields.insert(theExpr->rhs.name);
+      }
+  }
+
   StatusResult Filters::parse(Tokenizer &aTokenizer,Entity &anEntity) {
     StatusResult  theResult{noError};
 
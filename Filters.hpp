@@ -72,10 +72,14 @@ namespace ECE141 {
     ~Filters();
     
     size_t        getCount() const {return expressions.size();}
+    const Expressions& getExpressions() const {return expressions;}
     bool          matches(KeyValues &aList) const;
     Filters&      add(Expression *anExpression);
 
     Filters&      setLogic(Operators anOp);
+
+    //add the names of all fields referenced by the expressions
+    void          collectFields(StringSet &aFields) const;
         
     StatusResult  parse(Tokenizer &aTokenizer, Entity &anEntity);
     
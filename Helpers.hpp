@@ -12,6 +12,7 @@
 #include "BasicTypes.hpp"
 #include "keywords.hpp"
 #include <algorithm>
+#include <iostream>
 
 namespace ECE141 {
 
@@ -61,6 +62,7 @@ namespace ECE141 {
     std::make_pair("add",       Keywords::add_kw),
     std::make_pair("all",       Keywords::all_kw),
     std::make_pair("alter",     Keywords::alter_kw),
+    std::make_pair("analyze",   Keywords::analyze_kw),
     std::make_pair("and",       Keywords::and_kw),
     std::make_pair("as",        Keywords::as_kw),
     std::make_pair("asc",       Keywords::asc_kw),
@@ -71,6 +73,7 @@ namespace ECE141 {
     std::make_pair("by",        ECE141::Keywords::by_kw),
     std::make_pair("char",      ECE141::Keywords::char_kw),
     std::make_pair("column",    ECE141::Keywords::column_kw),
+    std::make_pair("copy",      ECE141::Keywords::copy_kw),
     std::make_pair("count",     ECE141::Keywords::count_kw),
     std::make_pair("create",    ECE141::Keywords::create_kw),
     std::make_pair("cross",     ECE141::Keywords::cross_kw),
@@ -112,11 +115,13 @@ namespace ECE141 {
     std::make_pair("left",      ECE141::Keywords::left_kw),
     std::make_pair("like",      ECE141::Keywords::like_kw),
     std::make_pair("limit",     ECE141::Keywords::limit_kw),
+    std::make_pair("load",      ECE141::Keywords::load_kw),
     std::make_pair("max",       ECE141::Keywords::max_kw),
     std::make_pair("min",       ECE141::Keywords::min_kw),
     std::make_pair("modify",    ECE141::Keywords::modify_kw),
     std::make_pair("not",       ECE141::Keywords::not_kw),
     std::make_pair("null",      ECE141::Keywords::null_kw),
+    std::make_pair("offset",    ECE141::Keywords::offset_kw),
     std::make_pair("on",        ECE141::Keywords::on_kw),
     std::make_pair("or",        ECE141::Keywords::or_kw),
     std::make_pair("order",     ECE141::Keywords::order_kw),
@@ -129,13 +134,16 @@ namespace ECE141 {
     std::make_pair("self",      ECE141::Keywords::self_kw),
     std::make_pair("set",       ECE141::Keywords::set_kw),
     std::make_pair("show",      ECE141::Keywords::show_kw),
+    std::make_pair("stats",     ECE141::Keywords::stats_kw),
     std::make_pair("sum",       ECE141::Keywords::sum_kw),
     std::make_pair("table",     ECE141::Keywords::table_kw),
     std::make_pair("tables",    ECE141::Keywords::tables_kw),
     std::make_pair("true",      ECE141::Keywords::true_kw),
+    std::make_pair("truncate",  ECE141::Keywords::truncate_kw),
     std::make_pair("unique",    ECE141::Keywords::unique_kw),
     std::make_pair("update",    ECE141::Keywords::update_kw),
     std::make_pair("use",       ECE141::Keywords::use_kw),
+    std::make_pair("vacuum",    ECE141::Keywords::vacuum_kw),
     std::make_pair("values",    ECE141::Keywords::values_kw),
     std::make_pair("varchar",   ECE141::Keywords::varchar_kw),
     std::make_pair("version",   ECE141::Keywords::version_kw),
@@ -234,6 +242,37 @@ namespace ECE141 {
       return false;
     }
 
+    //the type letter of stored text that holds " or \, which is written
+    //escaped; plain text keeps 's' and its old unescaped form, so values
+    //stored before escaping existed read back as they were
+    static const char kEscapedText = 'e';
+
+    static bool needsEscape(const std::string &aText) {
+      return aText.find_first_of("\"\\")!=std::string::npos;
+    }
+
+    //write a value as stored text in double quotes; when escaped, quotes
+    //and backslashes get a backslash before them so any text reads back whole
+    static void writeQuoted(std::ostream &anOutput, const std::string &aText, bool anEscaped) {
+      anOutput << '"';
+      for(char ch : aText) {
+        if(anEscaped && (ch=='"' || ch=='\\')) anOutput << '\\';
+        anOutput << ch;
+      }
+      anOutput << '"';
+    }
+
+    //read text written by writeQuoted, past its opening quote
+    static std::string readQuoted(std::istream &anInput, bool anEscaped) {
+      std::string theText;
+      char ch;
+      while(anInput.get(ch) && ch!='"') {
+        if(anEscaped && ch=='\\' && !anInput.get(ch)) break;
+        theText.push_back(ch);
+      }
+      return theText;
+    }
+
   };
   
   
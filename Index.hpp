@@ -10,7 +10,9 @@
 
 #include <stdio.h>
 #include <map>
-#include <map>
+#include <set>
+#include <vector>
+#include <optional>
 #include <functional>
 #include "Storage.hpp"
 #include "BasicTypes.hpp"
@@ -22,6 +24,17 @@ namespace ECE141 {
   enum class IndexType {intKey=0, strKey};
   
   using IndexVisitor = std::function<bool(const IndexKey&, uint32_t)>;
+
+  //keys between two optional bounds, each inclusive unless marked open
+  struct KeyRange {
+      std::optional<IndexKey> lower;
+      std::optional<IndexKey> upper;
+      bool lowerOpen = false;
+      bool upperOpen = false;
+      bool empty = false; //the bounds contradict each other
+
+      bool isFull() const { return !empty && !lower && !upper; }
+  };
     
   struct Index : public Storable, BlockIterator {
 
@@ -34,7 +47,7 @@ namespace ECE141 {
 
       Index(const Index& aCopy) : storage(aCopy.storage), data(aCopy.data), type(aCopy.type),
           name(aCopy.name), tableName(aCopy.tableName), blockNum(aCopy.blockNum),
-          changed(false) {}
+          changed(aCopy.changed) {}
 
       //added for compiler issue, should not be used
       Index& operator=(const Index& aCopy) {
@@ -44,7 +57,7 @@ namespace ECE141 {
           name = aCopy.name;
           tableName = aCopy.tableName;
           blockNum = aCopy.blockNum;
-          changed = false;
+          changed = aCopy.changed;
           return *this;
       }
 
@@ -126,6 +139,15 @@ namespace ECE141 {
           return changed;
       }
 
+      //add many key / block pairs at once; sorted pairs each land next to
+      //the one before, a repeated key keeps its last block like setKeyValue
+      void insertSorted(const std::vector<std::pair<IndexKey, uint32_t>>& aPairs) {
+          auto theHint = data.begin();
+          for (auto& thePair : aPairs)
+              theHint = std::next(data.insert_or_assign(theHint, thePair.first, thePair.second));
+          changed = changed || !aPairs.empty();
+      }
+
       /*StatusResult erase(const std::string &aKey) {
           if(data.count(aKey)) {
               data.erase(aKey);
@@ -148,8 +170,36 @@ namespace ECE141 {
           return StatusResult{ Errors::noError };
       }
 
+      //erase many keys at once; in sorted keys the next one is often the
+      //entry right after the last erased, which needs no search
+      void eraseSorted(const std::vector<IndexKey>& aKeys) {
+          auto theNext = data.begin();
+          for (auto& key : aKeys) {
+              if (theNext == data.end() || theNext->first != key)
+                  theNext = data.lower_bound(key);
+              if (theNext != data.end() && theNext->first == key) {
+                  theNext = data.erase(theNext);
+                  changed = true;
+              }
+          }
+      }
+
+      void clear() {
+          changed = changed || !data.empty();
+          data.clear();
+      }
+
       size_t getSize() { return data.size(); }
 
+      //smallest and largest key, answers min/max without a scan
+      std::optional<IndexKey> firstKey() const {
+          return data.empty() ? std::nullopt : std::optional<IndexKey>(data.begin()->first);
+      }
+
+      std::optional<IndexKey> lastKey() const {
+          return data.empty() ? std::nullopt : std::optional<IndexKey>(data.rbegin()->first);
+      }
+
       bool exists(IndexKey& aKey) {
           return data.count(aKey);
       }
@@ -215,6 +265,83 @@ namespace ECE141 {
           return true;
       }
 
+      //visit blocks in key order, or reverse key order
+      bool each(const BlockVisitor& aVisitor, bool anAscending) {
+          if (anAscending)
+              return each(aVisitor);
+
+          Block theBlock;
+          for (auto it = data.rbegin(); it != data.rend(); ++it) {
+              if (storage.readBlock(it->second, theBlock)) {
+                  if (!aVisitor(theBlock, it->second)) { return false; }
+              }
+          }
+          return true;
+      }
+
+      //visit the blocks of a key range in key order, or reverse key order
+      bool each(const KeyRange& aRange, const BlockVisitor& aVisitor, bool anAscending) {
+          Block theBlock;
+          return eachKV(aRange, [&](const IndexKey&, uint32_t aBlockNum) {
+              if (storage.readBlock(aBlockNum, theBlock))
+                  return aVisitor(theBlock, aBlockNum);
+              return true;
+              }, anAscending);
+      }
+
+      //visit the blocks of the given keys; the keys come sorted so the
+      //probes walk the index in key order, missing keys are skipped
+      bool each(const std::set<IndexKey>& aKeys, const BlockVisitor& aVisitor) {
+          Block theBlock;
+          auto theNext = data.begin();
+          for (auto& key : aKeys) {
+              theNext = data.lower_bound(key);
+              if (theNext == data.end())
+                  break;
+              if (theNext->first == key && storage.readBlock(theNext->second, theBlock)) {
+                  if (!aVisitor(theBlock, theNext->second)) { return false; }
+              }
+          }
+          return true;
+      }
+
+      //pull the block of the first key after aKey (the first key when aKey
+      //is empty) and move aKey to it; false at the end of the index
+      bool nextBlock(std::optional<IndexKey>& aKey, Block& aBlock) {
+          auto theNext = aKey ? data.upper_bound(*aKey) : data.begin();
+          if (theNext == data.end())
+              return false;
+          aKey = theNext->first;
+          return storage.readBlock(theNext->second, aBlock);
+      }
+
+      //visit the key / block pairs of a range in key order, or reverse key order
+      bool eachKV(const KeyRange& aRange, IndexVisitor aCall, bool anAscending = true) {
+          if (aRange.empty)
+              return true;
+          if (aRange.lower && aRange.upper && (*aRange.upper < *aRange.lower
+              || (*aRange.upper == *aRange.lower && (aRange.lowerOpen || aRange.upperOpen))))
+              return true;
+
+          auto theBegin = data.begin();
+          if (aRange.lower)
+              theBegin = aRange.lowerOpen ? data.upper_bound(*aRange.lower) : data.lower_bound(*aRange.lower);
+          auto theEnd = data.end();
+          if (aRange.upper)
+              theEnd = aRange.upperOpen ? data.lower_bound(*aRange.upper) : data.upper_bound(*aRange.upper);
+          if (anAscending) {
+              for (auto it = theBegin; it != theEnd; ++it) {
+                  if (!aCall(it->first, it->second)) { return false; }
+              }
+          }
+          else {
+              for (auto it = std::make_reverse_iterator(theEnd); it != std::make_reverse_iterator(theBegin); ++it) {
+                  if (!aCall(it->first, it->second)) { return false; }
+              }
+          }
+          return true;
+      }
+
       bool eachKV(IndexVisitor aCall) {
           for (auto thePair : data) {
               if (!aCall(thePair.first, thePair.second)) {
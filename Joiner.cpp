@@ -0,0 +1,143 @@
+//
+//  Joiner.cpp
+//
+//  Created by Yunhsiu Wu on 5/25/21.
+//
+
+#include <unordered_map>
+#include <vector>
+#include "Joiner.hpp"
+#include "Sorter.hpp"
+
+namespace ECE141 {
+
+    bool JoinOperator::isOuter() const {
+        return join.joinType == Keywords::left_kw || join.joinType == Keywords::right_kw;
+    }
+
+    bool JoinOperator::makeKey(Row& aRow, const std::string& aField, std::string& aKey) {
+        KeyValues& theData = aRow.getData();
+        auto theValue = theData.find(aField);
+        if (theValue == theData.end())
+            return false;
+
+        aKey.clear();
+        SortKey::append(aKey, &theValue->second);
+        return true;
+    }
+
+    std::unique_ptr<Row> JoinOperator::combine(Row& aLeft, Row* aRight) {
+        KeyValues theData = aLeft.getData();
+        if (aRight)
+            theData.insert(aRight->getData().begin(), aRight->getData().end());
+        return std::make_unique<Row>(theData, 0);
+    }
+
+    StatusResult HashJoin::run(RowCollection& aLeft, RowCollection& aRight, const RowVisitor& aVisitor) {
+        const std::string& leftField = join.onLeft.fieldName;
+        const std::string& rightField = join.onRight.fieldName;
+        std::string theKey;
+
+        //build on the right side, probe in left order
+        if (aRight.size() <= aLeft.size()) {
+            std::unordered_map<std::string, std::vector<Row*>> theTable;
+            for (auto& row : aRight) {
+                if (makeKey(*row, rightField, theKey))
+                    theTable[theKey].push_back(row.get());
+            }
+
+            for (auto& row : aLeft) {
+                auto theMatches = makeKey(*row, leftField, theKey) ? theTable.find(theKey) : theTable.end();
+                if (theMatches == theTable.end()) {
+                    if (isOuter() && !aVisitor(combine(*row, nullptr)))
+                        break;
+                    continue;
+                }
+                for (auto* match : theMatches->second) {
+                    if (!aVisitor(combine(*row, match)))
+                        return StatusResult{ Errors::noError };
+                }
+            }
+            return StatusResult{ Errors::noError };
+        }
+
+        //build on the left side, unmatched left rows are emitted last
+        std::unordered_map<std::string, std::vector<size_t>> theTable;
+        for (size_t i = 0; i < aLeft.size(); ++i) {
+            if (makeKey(*aLeft[i], leftField, theKey))
+                theTable[theKey].push_back(i);
+        }
+
+        std::vector<bool> matched(aLeft.size(), false);
+        for (auto& row : aRight) {
+            if (!makeKey(*row, rightField, theKey))
+                continue;
+            auto theMatches = theTable.find(theKey);
+            if (theMatches == theTable.end())
+                continue;
+            for (auto index : theMatches->second) {
+                matched[index] = true;
+                if (!aVisitor(combine(*aLeft[index], row.get())))
+                    return StatusResult{ Errors::noError };
+            }
+        }
+
+        if (isOuter()) {
+            for (size_t i = 0; i < aLeft.size(); ++i) {
+                if (!matched[i] && !aVisitor(combine(*aLeft[i], nullptr)))
+                    break;
+            }
+        }
+
+        return StatusResult{ Errors::noError };
+    }
+
+    void MergeJoin::advance() {
+        hasNext = false;
+        while (right(next)) {
+            if (makeKey(*next, join.onRight.fieldName, nextKey)) {
+                hasNext = true;
+                return;
+            }
+        }
+    }
+
+    bool MergeJoin::push(std::unique_ptr<Row> aLeft) {
+        if (!started) {
+            started = true;
+            advance();
+        }
+
+        std::string theKey;
+        if (!makeKey(*aLeft, join.onLeft.fieldName, theKey))
+            return isOuter() ? output(combine(*aLeft, nullptr)) : true;
+
+        //left keys only grow, so a new key replaces the current group
+        if (!hasGroup || groupKey != theKey) {
+            group.clear();
+            hasGroup = false;
+
+            while (hasNext && nextKey < theKey)
+                advance();
+
+            if (hasNext && nextKey == theKey) {
+                groupKey = theKey;
+                hasGroup = true;
+                while (hasNext && nextKey == theKey) {
+                    group.push_back(std::move(next));
+                    advance();
+                }
+            }
+        }
+
+        if (!hasGroup)
+            return isOuter() ? output(combine(*aLeft, nullptr)) : true;
+
+        for (auto& match : group) {
+            if (!output(combine(*aLeft, match.get())))
+                return false;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,81 @@
+//
+//  Joiner.hpp
+//
+//  Created by Yunhsiu Wu on 5/25/21.
+//
+
+#ifndef Joiner_hpp
+#define Joiner_hpp
+
+#include <string>
+#include <memory>
+#include <functional>
+#include "BasicTypes.hpp"
+#include "Errors.hpp"
+#include "Row.hpp"
+#include "Join.hpp"
+
+namespace ECE141 {
+
+    //pulls the next row of an input, false once it is exhausted
+    using RowSource = std::function<bool(std::unique_ptr<Row>&)>;
+
+    //state shared by the join operators
+    class JoinOperator {
+    public:
+        JoinOperator(const Join& aJoin) : join(aJoin) {}
+
+    protected:
+        //LEFT joins keep unmatched left rows (the parser already turned
+        //RIGHT joins into LEFT joins)
+        bool isOuter() const;
+
+        //normalized key of the join field, false if the row has no value
+        static bool makeKey(Row& aRow, const std::string& aField, std::string& aKey);
+
+        //merge a left row with its match (or nothing), left values win
+        static std::unique_ptr<Row> combine(Row& aLeft, Row* aRight);
+
+        const Join& join;
+    };
+
+    //equi-join of two row sets: a hash table is built once on the smaller
+    //input and probed with the other one
+    class HashJoin : public JoinOperator {
+    public:
+        HashJoin(const Join& aJoin) : JoinOperator(aJoin) {}
+
+        StatusResult run(RowCollection& aLeft, RowCollection& aRight, const RowVisitor& aVisitor);
+    };
+
+    //equi-join of two inputs that both arrive ordered on the join key, in a
+    //single pass; only the right rows of the current key are kept in memory
+    class MergeJoin : public JoinOperator {
+    public:
+        MergeJoin(const Join& aJoin, const RowSource& aRight, const RowVisitor& aVisitor)
+            : JoinOperator(aJoin), right(aRight), output(aVisitor),
+            hasNext(false), hasGroup(false), started(false) {}
+
+        //feed the left rows in join key order, false once the output stops
+        bool push(std::unique_ptr<Row> aLeft);
+
+    protected:
+        //read ahead to the next right row that has a key
+        void advance();
+
+        RowSource            right;
+        RowVisitor           output;
+
+        std::unique_ptr<Row> next; //right row read ahead
+        std::string          nextKey;
+        bool                 hasNext;
+
+        RowCollection        group; //right rows matching groupKey
+        std::string          groupKey;
+        bool                 hasGroup;
+        bool                 started;
+    };
+
+}
+
+#endif /* Joiner_hpp */
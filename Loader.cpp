@@ -0,0 +1,397 @@
+//
+//  Loader.cpp
+//
+//  Created by Yunhsiu Wu on 5/30/21.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include "Loader.hpp"
+
+namespace ECE141 {
+
+    ChunkReader::ChunkReader(std::istream& anInput, LoadFormat aFormat, size_t aChunkSize, size_t aFirstLine)
+        : input(anInput), format(aFormat), chunkSize(std::max(aChunkSize, size_t(1))), line(aFirstLine) {}
+
+    size_t ChunkReader::recordsEnd(const std::string& aText) const {
+        if (format == LoadFormat::json) {
+            size_t theLast = aText.rfind('\n');
+            return theLast == std::string::npos ? 0 : theLast + 1;
+        }
+
+        //a CSV record may hold line breaks inside quotes; chunks start on a
+        //record, so the quotes seen so far tell whether a break ends one
+        size_t theEnd = 0;
+        bool quoted = false;
+        for (size_t i = 0; i < aText.size(); ++i) {
+            if (aText[i] == '"')
+                quoted = !quoted;
+            else if (aText[i] == '\n' && !quoted)
+                theEnd = i + 1;
+        }
+        return theEnd;
+    }
+
+    bool ChunkReader::next(std::string& aChunk, size_t& aLine) {
+        aChunk.swap(carry);
+        carry.clear();
+
+        //read until the chunk holds a whole record, or the file ends
+        size_t theEnd = 0;
+        while (true) {
+            size_t theSize = aChunk.size();
+            aChunk.resize(theSize + chunkSize);
+            input.read(&aChunk[theSize], chunkSize);
+            aChunk.resize(theSize + size_t(input.gcount()));
+            if (!input) {
+                theEnd = aChunk.size();
+                break;
+            }
+            if ((theEnd = recordsEnd(aChunk)))
+                break;
+        }
+
+        carry.assign(aChunk, theEnd, std::string::npos);
+        aChunk.resize(theEnd);
+        aLine = line;
+        line += std::count(aChunk.begin(), aChunk.end(), '\n');
+        return !aChunk.empty();
+    }
+
+    //---------------------------------------------------
+
+    RowParser::RowParser(const std::vector<LoadColumn>& aColumns, LoadFormat aFormat)
+        : columns(aColumns), format(aFormat) {
+        for (size_t i = 0; i < columns.size(); ++i)
+            columnIndex[columns[i].name] = i;
+    }
+
+    namespace {
+        //one CSV record from aPos on; fields in quotes may hold commas, line
+        //breaks and doubled quotes, and are never null
+        bool readRecord(const std::string& aText, size_t& aPos, size_t& aLine,
+            StringList& aFields, std::vector<bool>& aQuoted) {
+            aFields.clear();
+            aQuoted.clear();
+            size_t theSize = aText.size();
+            bool more = true;
+            while (more) {
+                std::string theField;
+                bool quoted = aPos < theSize && aText[aPos] == '"';
+                if (quoted) {
+                    for (++aPos; ; ) {
+                        if (aPos >= theSize)
+                            return false;
+                        char theChar = aText[aPos++];
+                        if (theChar == '"') {
+                            if (aPos < theSize && aText[aPos] == '"')
+                                ++aPos;
+                            else
+                                break;
+                        }
+                        else if (theChar == '\n')
+                            ++aLine;
+                        theField.push_back(theChar);
+                    }
+                }
+
+                size_t theStop = std::min(aText.find_first_of(",\n", aPos), theSize);
+                if (quoted) {
+                    //only blanks may follow the closing quote
+                    for (size_t i = aPos; i < theStop; ++i) {
+                        if (!std::isspace(static_cast<unsigned char>(aText[i])))
+                            return false;
+                    }
+                }
+                else {
+                    theField.assign(aText, aPos, theStop - aPos);
+                    if (!theField.empty() && theField.back() == '\r')
+                        theField.pop_back();
+                }
+
+                aPos = theStop;
+                if (aPos < theSize && aText[aPos] == ',')
+                    ++aPos;
+                else {
+                    more = false;
+                    if (aPos < theSize) {
+                        ++aPos;
+                        ++aLine;
+                    }
+                }
+                aFields.push_back(std::move(theField));
+                aQuoted.push_back(quoted);
+            }
+            return true;
+        }
+
+        //reads the text of one JSON line
+        struct JSONCursor {
+            const char* at;
+            const char* end;
+
+            void skipSpace() {
+                while (at < end && std::isspace(static_cast<unsigned char>(*at)))
+                    ++at;
+            }
+
+            bool skipIf(char aChar) {
+                skipSpace();
+                if (at < end && *at == aChar) {
+                    ++at;
+                    return true;
+                }
+                return false;
+            }
+
+            bool skipWord(const char* aWord) {
+                const char* theStart = at;
+                for (; *aWord; ++aWord, ++at) {
+                    if (at >= end || *at != *aWord) {
+                        at = theStart;
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            static void appendUTF8(std::string& aText, uint32_t aCode) {
+                if (aCode < 0x80)
+                    aText.push_back(char(aCode));
+                else if (aCode < 0x800) {
+                    aText.push_back(char(0xC0 | (aCode >> 6)));
+                    aText.push_back(char(0x80 | (aCode & 0x3F)));
+                }
+                else if (aCode < 0x10000) {
+                    aText.push_back(char(0xE0 | (aCode >> 12)));
+                    aText.push_back(char(0x80 | ((aCode >> 6) & 0x3F)));
+                    aText.push_back(char(0x80 | (aCode & 0x3F)));
+                }
+                else {
+                    aText.push_back(char(0xF0 | (aCode >> 18)));
+                    aText.push_back(char(0x80 | ((aCode >> 12) & 0x3F)));
+                    aText.push_back(char(0x80 | ((aCode >> 6) & 0x3F)));
+                    aText.push_back(char(0x80 | (aCode & 0x3F)));
+                }
+            }
+
+            bool readHex(uint32_t& aCode) {
+                if (end - at < 4)
+                    return false;
+                aCode = 0;
+                for (int i = 0; i < 4; ++i, ++at) {
+                    char theChar = std::tolower(static_cast<unsigned char>(*at));
+                    if (!std::isxdigit(static_cast<unsigned char>(theChar)))
+                        return false;
+                    aCode = aCode * 16 + (std::isdigit(static_cast<unsigned char>(theChar)) ? theChar - '0' : theChar - 'a' + 10);
+                }
+                return true;
+            }
+
+            bool readString(std::string& aText) {
+                if (!skipIf('"'))
+                    return false;
+                aText.clear();
+                while (at < end) {
+                    char theChar = *at++;
+                    if (theChar == '"')
+                        return true;
+                    if (theChar != '\\') {
+                        aText.push_back(theChar);
+                        continue;
+                    }
+                    if (at >= end)
+                        return false;
+                    switch (char theEscape = *at++) {
+                        case 'b': aText.push_back('\b'); break;
+                        case 'f': aText.push_back('\f'); break;
+                        case 'n': aText.push_back('\n'); break;
+                        case 'r': aText.push_back('\r'); break;
+                        case 't': aText.push_back('\t'); break;
+                        case 'u': {
+                            uint32_t theCode, theLow;
+                            if (!readHex(theCode))
+                                return false;
+                            //a surrogate pair is one code point
+                            if (theCode >= 0xD800 && theCode < 0xDC00 && skipWord("\\u")) {
+                                if (!readHex(theLow) || theLow < 0xDC00 || theLow >= 0xE000)
+                                    return false;
+                                theCode = 0x10000 + ((theCode - 0xD800) << 10) + (theLow - 0xDC00);
+                            }
+                            appendUTF8(aText, theCode);
+                            break;
+                        }
+                        default: aText.push_back(theEscape); break;
+                    }
+                }
+                return false;
+            }
+
+            //a string, number or literal as text; objects and arrays fail
+            bool readScalar(std::string& aText, bool& isNull) {
+                skipSpace();
+                isNull = false;
+                if (at < end && *at == '"')
+                    return readString(aText);
+                if (skipWord("null"))
+                    return isNull = true;
+                for (const char* theWord : { "true", "false" }) {
+                    if (skipWord(theWord)) {
+                        aText = theWord;
+                        return true;
+                    }
+                }
+                const char* theStart = at;
+                while (at < end && (std::isdigit(static_cast<unsigned char>(*at)) || std::strchr("+-.eE", *at)))
+                    ++at;
+                aText.assign(theStart, at);
+                return at > theStart;
+            }
+        };
+    }
+
+    StatusResult RowParser::readHeader(const std::string& aLine) {
+        size_t thePos = 0, theLine = 1;
+        StringList theNames;
+        std::vector<bool> theQuoted;
+        if (!readRecord(aLine, thePos, theLine, theNames, theQuoted))
+            return StatusResult{ Errors::syntaxError, 1 };
+
+        fields.clear();
+        for (auto& name : theNames) {
+            auto theColumn = columnIndex.find(name);
+            if (theColumn == columnIndex.end())
+                return StatusResult{ Errors::unknownAttribute, 1 };
+            if (std::find(fields.begin(), fields.end(), theColumn->second) != fields.end())
+                return StatusResult{ Errors::invalidArguments, 1 };
+            fields.push_back(theColumn->second);
+        }
+        return StatusResult{ Errors::noError };
+    }
+
+    StatusResult RowParser::parse(const std::string& aChunk, size_t aLine, std::vector<KeyValues>& aRows) const {
+        return format == LoadFormat::csv ? parseCSV(aChunk, aLine, aRows) : parseJSON(aChunk, aLine, aRows);
+    }
+
+    StatusResult RowParser::parseCSV(const std::string& aChunk, size_t aLine, std::vector<KeyValues>& aRows) const {
+        StringList theFields;
+        std::vector<bool> theQuoted;
+        size_t thePos = 0;
+        while (thePos < aChunk.size()) {
+            size_t theLine = aLine;
+            if (!readRecord(aChunk, thePos, aLine, theFields, theQuoted))
+                return StatusResult{ Errors::syntaxError, uint32_t(theLine) };
+
+            //blank lines hold no record
+            if (theFields.size() == 1 && !theQuoted[0] && theFields[0].empty())
+                continue;
+            if (theFields.size() != fields.size())
+                return StatusResult{ Errors::keyValueMismatch, uint32_t(theLine) };
+
+            //an empty field without quotes is null, i.e. left out of the row
+            KeyValues theRow;
+            for (size_t i = 0; i < theFields.size(); ++i) {
+                if (theFields[i].empty() && !theQuoted[i])
+                    continue;
+                const LoadColumn& theColumn = columns[fields[i]];
+                Value theValue;
+                if (!toValue(theColumn, theFields[i], theValue))
+                    return StatusResult{ Errors::unexpectedValue, uint32_t(theLine) };
+                theRow.emplace(theColumn.name, std::move(theValue));
+            }
+            aRows.push_back(std::move(theRow));
+        }
+        return StatusResult{ Errors::noError };
+    }
+
+    StatusResult RowParser::parseJSON(const std::string& aChunk, size_t aLine, std::vector<KeyValues>& aRows) const {
+        std::string theKey, theText;
+        for (size_t thePos = 0; thePos < aChunk.size(); ++aLine) {
+            size_t theEnd = std::min(aChunk.find('\n', thePos), aChunk.size());
+            JSONCursor theCursor{ aChunk.data() + thePos, aChunk.data() + theEnd };
+            thePos = theEnd + 1;
+
+            theCursor.skipSpace();
+            if (theCursor.at == theCursor.end)
+                continue;
+
+            StatusResult theError{ Errors::syntaxError, uint32_t(aLine) };
+            if (!theCursor.skipIf('{'))
+                return theError;
+
+            KeyValues theRow;
+            bool more = !theCursor.skipIf('}');
+            while (more) {
+                bool isNull;
+                if (!theCursor.readString(theKey) || !theCursor.skipIf(':') || !theCursor.readScalar(theText, isNull))
+                    return theError;
+
+                auto theColumn = columnIndex.find(theKey);
+                if (theColumn == columnIndex.end())
+                    return StatusResult{ Errors::unknownAttribute, uint32_t(aLine) };
+                if (!isNull) {
+                    Value theValue;
+                    if (!toValue(columns[theColumn->second], theText, theValue))
+                        return StatusResult{ Errors::unexpectedValue, uint32_t(aLine) };
+                    theRow[theKey] = std::move(theValue);
+                }
+
+                if (!theCursor.skipIf(','))
+                    more = false;
+            }
+            if (!theCursor.skipIf('}'))
+                return theError;
+            theCursor.skipSpace();
+            if (theCursor.at != theCursor.end)
+                return theError;
+            aRows.push_back(std::move(theRow));
+        }
+        return StatusResult{ Errors::noError };
+    }
+
+    bool RowParser::toValue(const LoadColumn& aColumn, const std::string& aText, Value& aValue) {
+        const char* theStart = aText.c_str();
+        char* theEnd = nullptr;
+        errno = 0;
+
+        switch (aColumn.type) {
+            case DataTypes::bool_type: {
+                std::string theText(aText);
+                std::transform(theText.begin(), theText.end(), theText.begin(), ::tolower);
+                if (theText != "1" && theText != "0" && theText != "true" && theText != "false")
+                    return false;
+                aValue = theText == "1" || theText == "true";
+                return true;
+            }
+
+            case DataTypes::int_type: {
+                long theNumber = std::strtol(theStart, &theEnd, 10);
+                if (theEnd == theStart || *theEnd || errno || theNumber < INT_MIN || theNumber > INT_MAX)
+                    return false;
+                aValue = int(theNumber);
+                return true;
+            }
+
+            case DataTypes::float_type: {
+                double theNumber = std::strtod(theStart, &theEnd);
+                if (theEnd == theStart || *theEnd || errno)
+                    return false;
+                aValue = theNumber;
+                return true;
+            }
+
+            case DataTypes::varchar_type:
+                aValue = aColumn.length > 0 ? aText.substr(0, aColumn.length) : aText;
+                return true;
+
+            default:
+                aValue = aText;
+                return true;
+        }
+    }
+
+}
@@ -0,0 +1,76 @@
+//
+//  Loader.hpp
+//
+//  Created by Yunhsiu Wu on 5/30/21.
+//
+
+#ifndef Loader_hpp
+#define Loader_hpp
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unordered_map>
+#include "BasicTypes.hpp"
+#include "Errors.hpp"
+
+namespace ECE141 {
+
+    enum class LoadFormat { csv, json };
+
+    //a table column as the loader converts text for it
+    struct LoadColumn {
+        std::string name;
+        DataTypes   type;
+        int         length; //varchar length
+    };
+
+    //cuts a data file into chunks of whole records, so that every chunk
+    //parses on its own
+    class ChunkReader {
+    public:
+        ChunkReader(std::istream& anInput, LoadFormat aFormat, size_t aChunkSize, size_t aFirstLine = 1);
+
+        //the next chunk and the line it starts on, false at the end of the file
+        bool    next(std::string& aChunk, size_t& aLine);
+
+    protected:
+        //end of the last complete record in aText, 0 if there is none
+        size_t  recordsEnd(const std::string& aText) const;
+
+        std::istream&   input;
+        LoadFormat      format;
+        size_t          chunkSize;
+        size_t          line;
+        std::string     carry; //the incomplete record after the last chunk
+    };
+
+    //turns the records of a chunk into rows: CSV lines with the fields of
+    //the header, or JSON objects with one flat object per line
+    class RowParser {
+    public:
+        RowParser(const std::vector<LoadColumn>& aColumns, LoadFormat aFormat);
+
+        //CSV: the header line names the column of each field
+        StatusResult    readHeader(const std::string& aLine);
+
+        //a failed result holds the line of the bad record, and aRows the rows
+        //before it
+        StatusResult    parse(const std::string& aChunk, size_t aLine, std::vector<KeyValues>& aRows) const;
+
+    protected:
+        StatusResult    parseCSV(const std::string& aChunk, size_t aLine, std::vector<KeyValues>& aRows) const;
+        StatusResult    parseJSON(const std::string& aChunk, size_t aLine, std::vector<KeyValues>& aRows) const;
+
+        //text of a field as a value of its column, false if it does not fit
+        static bool     toValue(const LoadColumn& aColumn, const std::string& aText, Value& aValue);
+
+        std::vector<LoadColumn>                 columns;
+        std::unordered_map<std::string, size_t> columnIndex;
+        std::vector<size_t>                     fields; //CSV: column of each field
+        LoadFormat                              format;
+    };
+
+}
+
+#endif /* Loader_hpp */
@@ -0,0 +1,40 @@
+//
+//  Plan.cpp
+//
+//  Created by Yunhsiu Wu on 5/27/21.
+//
+
+#include "Plan.hpp"
+#include "BlockIO.hpp"
+
+namespace ECE141 {
+
+    PlanScope::PlanScope(QueryPlan* aPlan, const std::string& anOperation, const std::string& aDetail)
+        : plan(aPlan), step(0), rows(0), blocks(0) {
+        if (!plan)
+            return;
+
+        step = plan->steps.size();
+        plan->steps.push_back(PlanStep{ anOperation, aDetail, plan->depth, 0, 0.0, 0 });
+        ++plan->depth;
+        blocks = BlockIO::getReadCount();
+        timer.start();
+    }
+
+    PlanScope::~PlanScope() {
+        if (!plan)
+            return;
+
+        --plan->depth;
+        PlanStep& theStep = plan->steps[step];
+        theStep.rows = rows;
+        theStep.elapsed = timer.stop().elapsed();
+        theStep.blocks = BlockIO::getReadCount() - blocks;
+    }
+
+    void PlanScope::addDetail(const std::string& aDetail) {
+        if (plan)
+            plan->steps[step].detail += aDetail;
+    }
+
+}
@@ -0,0 +1,71 @@
+//
+//  Plan.hpp
+//
+//  Created by Yunhsiu Wu on 5/27/21.
+//
+
+#ifndef Plan_hpp
+#define Plan_hpp
+
+#include <string>
+#include <vector>
+#include "Timer.hpp"
+
+namespace ECE141 {
+
+    //one operator of a query plan, the counters are filled by EXPLAIN ANALYZE
+    struct PlanStep {
+        std::string operation;  //e.g. "scan", "hash join", "sort"
+        std::string detail;     //table, keys and strategy
+        size_t      depth;      //steps started by another one are nested below it
+        size_t      rows;       //rows the operator produced
+        double      elapsed;    //seconds, including the operators it started
+        size_t      blocks;     //blocks read from storage, same
+    };
+
+    //the operators a select runs, in the order they start; without analyze
+    //the operators only describe themselves and read nothing
+    class QueryPlan {
+    public:
+        QueryPlan(bool anAnalyze) : depth(0), analyze(anAnalyze) {}
+
+        bool isAnalyze() const { return analyze; }
+        const std::vector<PlanStep>& getSteps() const { return steps; }
+
+    protected:
+        friend class PlanScope;
+
+        std::vector<PlanStep>   steps;
+        size_t                  depth;
+        bool                    analyze;
+    };
+
+    //an operator while it runs: adds its step to the plan and measures it,
+    //does nothing without a plan
+    class PlanScope {
+    public:
+        PlanScope(QueryPlan* aPlan, const std::string& anOperation, const std::string& aDetail);
+        ~PlanScope();
+
+        PlanScope(const PlanScope&) = delete;
+        PlanScope& operator=(const PlanScope&) = delete;
+
+        void    addRows(size_t aCount = 1) { rows += aCount; }
+        void    setRows(size_t aCount) { rows = aCount; }
+        //e.g. what the operator only learns while it runs (spilled runs...)
+        void    addDetail(const std::string& aDetail);
+
+        //EXPLAIN without ANALYZE: record the step, skip the work
+        bool    describeOnly() const { return plan && !plan->isAnalyze(); }
+
+    protected:
+        QueryPlan*  plan;
+        size_t      step;
+        size_t      rows;
+        size_t      blocks; //read count when the operator started
+        Timer       timer;
+    };
+
+}
+
+#endif /* Plan_hpp */
@@ -0,0 +1,345 @@
+//
+//  Planner.cpp
+//
+//  Created by Yunhsiu Wu on 5/28/21.
+//
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <algorithm>
+#include "Planner.hpp"
+#include "BlockIO.hpp"
+
+namespace ECE141 {
+
+    const double kBlockCost = 1.0;          //read one block of a scan
+    const double kProbeCost = 1.5;          //find a key and read its block
+    const double kRowCost = 0.01;           //compare or copy a row in memory
+    const double kHashCost = 0.02;          //hash a row and insert or probe it
+    const double kEqualFraction = 0.1;      //= on a column without statistics
+    const double kRangeFraction = 1.0 / 3;  //<, > ... without statistics
+
+    static std::optional<double> toNumber(const Value& aValue) {
+        if (auto* theInt = std::get_if<int>(&aValue))
+            return *theInt;
+        if (auto* theDouble = std::get_if<double>(&aValue))
+            return *theDouble;
+        return std::nullopt;
+    }
+
+    //field op constant, with the operator turned around for constant op field
+    static bool getComparison(const Expression& anExpr, std::string& aField,
+                              Operators& anOp, Value& aValue) {
+        bool theLeft = TokenType::identifier == anExpr.lhs.ttype;
+        bool theRight = TokenType::identifier == anExpr.rhs.ttype;
+        if (theLeft == theRight)
+            return false;
+
+        anOp = anExpr.op;
+        if (theLeft) {
+            aField = anExpr.lhs.name;
+            aValue = anExpr.rhs.value;
+            return true;
+        }
+
+        aField = anExpr.rhs.name;
+        aValue = anExpr.lhs.value;
+        switch (anOp) {
+            case Operators::lt_op:  anOp = Operators::gt_op; break;
+            case Operators::lte_op: anOp = Operators::gte_op; break;
+            case Operators::gt_op:  anOp = Operators::lt_op; break;
+            case Operators::gte_op: anOp = Operators::lte_op; break;
+            default: break;
+        }
+        return true;
+    }
+
+    //share of a column's values below aValue: from the histogram buckets,
+    //else interpolated between the smallest and largest value
+    static std::optional<double> getBelow(const ColumnStats& aColumn, const Value& aValue) {
+        const std::vector<Value>& theBounds = aColumn.histogram;
+        if (theBounds.size() >= 2) {
+            size_t theBuckets = theBounds.size() - 1;
+            for (size_t i = 0; i < theBuckets; ++i) {
+                std::optional<int> theUpper = compareValues(aValue, theBounds[i + 1]);
+                if (!theUpper)
+                    return std::nullopt;
+                if (*theUpper > 0)
+                    continue;
+                if (compareValues(aValue, theBounds[i]).value_or(0) <= 0)
+                    return double(i) / theBuckets;
+
+                //within a bucket numbers spread evenly, anything else counts half
+                double theWithin = 0.5;
+                std::optional<double> theNumber = toNumber(aValue);
+                std::optional<double> theLow = toNumber(theBounds[i]);
+                std::optional<double> theHigh = toNumber(theBounds[i + 1]);
+                if (theNumber && theLow && theHigh && *theHigh > *theLow)
+                    theWithin = (*theNumber - *theLow) / (*theHigh - *theLow);
+                return (i + theWithin) / theBuckets;
+            }
+            return 1.0;
+        }
+
+        if (!aColumn.min || !aColumn.max)
+            return std::nullopt;
+        std::optional<double> theNumber = toNumber(aValue);
+        std::optional<double> theMin = toNumber(*aColumn.min);
+        std::optional<double> theMax = toNumber(*aColumn.max);
+        if (!theNumber || !theMin || !theMax)
+            return std::nullopt;
+        double theBelow = *theMax > *theMin
+            ? (*theNumber - *theMin) / (*theMax - *theMin)
+            : (*theNumber < *theMin ? 0.0 : 1.0);
+        return std::clamp(theBelow, 0.0, 1.0);
+    }
+
+    static double getFraction(const Expression& anExpr, const TableStats& aStats) {
+        std::string theField;
+        Operators   theOp;
+        Value       theValue;
+        if (!getComparison(anExpr, theField, theOp, theValue))
+            return kRangeFraction;
+
+        //comparisons never match a missing value
+        const ColumnStats* theColumn = aStats.getColumn(theField);
+        double theValued = theColumn && aStats.rows
+            ? 1.0 - std::min(1.0, double(theColumn->nulls) / aStats.rows) : 1.0;
+
+        size_t theDistinct = aStats.getDistinct(theField);
+        double theEqual = theDistinct ? 1.0 / theDistinct : kEqualFraction;
+        if (Operators::equal_op == theOp)
+            return theEqual * theValued;
+        if (Operators::notequal_op == theOp)
+            return (1.0 - theEqual) * theValued;
+
+        std::optional<double> theBelow = theColumn ? getBelow(*theColumn, theValue) : std::nullopt;
+        if (!theBelow)
+            return kRangeFraction;
+        switch (theOp) {
+            case Operators::lt_op:
+            case Operators::lte_op: return *theBelow * theValued;
+            case Operators::gt_op:
+            case Operators::gte_op: return (1.0 - *theBelow) * theValued;
+            default: return kRangeFraction;
+        }
+    }
+
+    //the filters run as Filters::matches does: an expression marked "or" is
+    //tried with the one after it, one marked "not" must fail
+    double Planner::selectivity(const Filters& aFilters, const TableStats& aStats) const {
+        const Expressions& theExprs = aFilters.getExpressions();
+        double theResult = 1.0;
+        for (size_t i = 0; i < theExprs.size(); ++i) {
+            double theFraction = getFraction(*theExprs[i], aStats);
+            if (Logical::or_op == theExprs[i]->logic && i + 1 < theExprs.size()) {
+                double theOther = getFraction(*theExprs[++i], aStats);
+                theFraction = theFraction + theOther - theFraction * theOther;
+            }
+            else if (Logical::not_op == theExprs[i]->logic)
+                theFraction = 1.0 - theFraction;
+            theResult *= theFraction;
+        }
+        return theResult;
+    }
+
+    //---------------------------------------------------
+
+    static void raiseLower(KeyRange& aRange, const IndexKey& aKey, bool anOpen) {
+        if (!aRange.lower || *aRange.lower < aKey || (*aRange.lower == aKey && anOpen)) {
+            aRange.lower = aKey;
+            aRange.lowerOpen = anOpen;
+        }
+    }
+
+    static void dropUpper(KeyRange& aRange, const IndexKey& aKey, bool anOpen) {
+        if (!aRange.upper || aKey < *aRange.upper || (*aRange.upper == aKey && anOpen)) {
+            aRange.upper = aKey;
+            aRange.upperOpen = anOpen;
+        }
+    }
+
+    //integer keys are narrowed to inclusive bounds
+    static void narrowInt(KeyRange& aRange, Operators anOp, double aValue) {
+        const double theMax = std::numeric_limits<uint32_t>::max();
+        switch (anOp) {
+            case Operators::equal_op:
+                if (aValue < 0 || aValue > theMax || aValue != std::floor(aValue))
+                    aRange.empty = true;
+                else {
+                    raiseLower(aRange, (uint32_t)aValue, false);
+                    dropUpper(aRange, (uint32_t)aValue, false);
+                }
+                break;
+            case Operators::gt_op:
+                if (aValue >= theMax)
+                    aRange.empty = true;
+                else if (aValue >= 0)
+                    raiseLower(aRange, (uint32_t)std::floor(aValue) + 1, false);
+                break;
+            case Operators::gte_op:
+                if (aValue > theMax)
+                    aRange.empty = true;
+                else if (aValue > 0)
+                    raiseLower(aRange, (uint32_t)std::ceil(aValue), false);
+                break;
+            case Operators::lt_op:
+                if (aValue <= 0)
+                    aRange.empty = true;
+                else if (aValue <= theMax)
+                    dropUpper(aRange, (uint32_t)std::ceil(aValue) - 1, false);
+                break;
+            case Operators::lte_op:
+                if (aValue < 0)
+                    aRange.empty = true;
+                else if (aValue < theMax)
+                    dropUpper(aRange, (uint32_t)std::floor(aValue), false);
+                break;
+            default: break;
+        }
+    }
+
+    static void narrowString(KeyRange& aRange, Operators anOp, const std::string& aValue) {
+        switch (anOp) {
+            case Operators::equal_op:
+                raiseLower(aRange, aValue, false);
+                dropUpper(aRange, aValue, false);
+                break;
+            case Operators::gt_op:  raiseLower(aRange, aValue, true); break;
+            case Operators::gte_op: raiseLower(aRange, aValue, false); break;
+            case Operators::lt_op:  dropUpper(aRange, aValue, true); break;
+            case Operators::lte_op: dropUpper(aRange, aValue, false); break;
+            default: break;
+        }
+    }
+
+    //only comparisons every matching row must pass bound the range: none
+    //tried as part of an "or", none negated
+    ScanPlan Planner::planScan(const Filters& aFilters, const TableStats& aStats,
+                               const std::string& aKey, IndexType aKeyType) const {
+        ScanPlan thePlan;
+        thePlan.rows = aStats.rows * selectivity(aFilters, aStats);
+        thePlan.cost = aStats.rows * kBlockCost;
+
+        const Expressions& theExprs = aFilters.getExpressions();
+        KeyRange theRange;
+        double   theFraction = 1.0; //of the rows in the range
+        for (size_t i = 0; i < theExprs.size(); ++i) {
+            const Expression& theExpr = *theExprs[i];
+            if (Logical::or_op == theExpr.logic) {
+                ++i; //its partner is optional too
+                continue;
+            }
+            std::string theField;
+            Operators   theOp;
+            Value       theValue;
+            if (Logical::not_op == theExpr.logic
+                || !getComparison(theExpr, theField, theOp, theValue) || theField != aKey)
+                continue;
+
+            std::optional<double> theNumber = toNumber(theValue);
+            auto* theString = std::get_if<std::string>(&theValue);
+            if (IndexType::intKey == aKeyType && theNumber)
+                narrowInt(theRange, theOp, *theNumber);
+            else if (IndexType::strKey == aKeyType && theString)
+                narrowString(theRange, theOp, *theString);
+            else
+                continue;
+            theFraction *= getFraction(theExpr, aStats);
+        }
+
+        if (!theRange.isFull()) {
+            double theCost = kProbeCost + aStats.rows * theFraction * kBlockCost;
+            if (theRange.empty || theCost < thePlan.cost) {
+                thePlan.range = theRange;
+                thePlan.cost = theRange.empty ? kProbeCost : theCost;
+            }
+        }
+        if (theRange.empty)
+            thePlan.rows = 0;
+        return thePlan;
+    }
+
+    //---------------------------------------------------
+
+    double Planner::sortCost(double aRows) const {
+        double theCost = aRows * std::log2(std::max(aRows, 2.0)) * kRowCost;
+        if (aRows * kPayloadSize > memory)
+            theCost += 2 * aRows * kBlockCost; //runs written and read back
+        return theCost;
+    }
+
+    double Planner::joinRows(const JoinInput& aLeft, const JoinInput& aRight, bool anOuter) {
+        double theDistinct = std::max({ aLeft.distinct, aRight.distinct, 1.0 });
+        double theRows = aLeft.rows * aRight.rows / theDistinct;
+        return anOuter ? std::max(theRows, aLeft.rows) : theRows;
+    }
+
+    //the right table is read here, the left rows are already in memory
+    JoinPlan Planner::planJoin(const JoinInput& aLeft, const JoinInput& aRight, bool anOuter) const {
+        JoinPlan thePlan;
+        thePlan.rows = joinRows(aLeft, aRight, anOuter);
+
+        //hash join: scan the right table and hash the smaller side in memory
+        double theSmaller = std::min(aLeft.rows, aRight.rows);
+        thePlan.method = JoinMethod::hash;
+        thePlan.cost = theSmaller * kPayloadSize <= memory
+            ? aRight.rows * kBlockCost + (aLeft.rows + aRight.rows) * kHashCost
+            : std::numeric_limits<double>::infinity();
+
+        //index nested loop: probe the right index once per distinct left key
+        if (aRight.indexed) {
+            double theProbes = std::min({ aLeft.rows, aLeft.distinct, aRight.rows });
+            double theCost = theProbes * kProbeCost + aLeft.rows * kRowCost;
+            if (theCost < thePlan.cost) {
+                thePlan.method = JoinMethod::indexLoop;
+                thePlan.cost = theCost;
+            }
+        }
+
+        //merge join: walk both sides in key order, sorting what is not
+        double theCost = aRight.rows * kBlockCost
+            + (aRight.ordered ? 0.0 : sortCost(aRight.rows))
+            + (aLeft.ordered ? 0.0 : sortCost(aLeft.rows))
+            + (aLeft.rows + aRight.rows) * kRowCost;
+        if (theCost < thePlan.cost) {
+            thePlan.method = JoinMethod::merge;
+            thePlan.cost = theCost;
+        }
+        return thePlan;
+    }
+
+    //---------------------------------------------------
+
+    static std::string toString(const IndexKey& aKey) {
+        std::stringstream theOutput;
+        std::visit([&](const auto& aValue) { theOutput << aValue; }, aKey);
+        return theOutput.str();
+    }
+
+    std::string Planner::describe(const KeyRange& aRange, const std::string& aKey) {
+        if (aRange.empty)
+            return "no " + aKey;
+        if (aRange.lower && aRange.upper && *aRange.lower == *aRange.upper)
+            return aKey + " = " + toString(*aRange.lower);
+
+        std::string theResult;
+        if (aRange.lower)
+            theResult = aKey + (aRange.lowerOpen ? " > " : " >= ") + toString(*aRange.lower);
+        if (aRange.upper) {
+            theResult += theResult.empty() ? "" : " and ";
+            theResult += aKey + (aRange.upperOpen ? " < " : " <= ") + toString(*aRange.upper);
+        }
+        return theResult;
+    }
+
+    std::string Planner::describe(JoinMethod aMethod) {
+        switch (aMethod) {
+            case JoinMethod::indexLoop: return "index nested loop join";
+            case JoinMethod::merge:     return "merge join";
+            default:                    return "hash join";
+        }
+    }
+
+}
@@ -0,0 +1,74 @@
+//
+//  Planner.hpp
+//
+//  Created by Yunhsiu Wu on 5/28/21.
+//
+
+#ifndef Planner_hpp
+#define Planner_hpp
+
+#include <string>
+#include <map>
+#include <optional>
+#include "BasicTypes.hpp"
+#include "Filters.hpp"
+#include "Entity.hpp"
+#include "Index.hpp"
+#include "Config.hpp"
+#include "Statistics.hpp"
+
+namespace ECE141 {
+
+    //how a table is read
+    struct ScanPlan {
+        KeyRange range;    //primary key range read, full for a table scan
+        double   rows = 0; //rows estimated to pass the filters
+        double   cost = 0;
+    };
+
+    enum class JoinMethod { hash, indexLoop, merge };
+
+    //one side of an equi-join as the planner sees it
+    struct JoinInput {
+        double rows = 0;        //estimated rows
+        double distinct = 0;    //estimated distinct join keys
+        bool   ordered = false; //arrives sorted on the join key
+        bool   indexed = false; //the join key has an index to probe
+    };
+
+    struct JoinPlan {
+        JoinMethod method = JoinMethod::hash;
+        double     rows = 0; //estimated output rows
+        double     cost = 0;
+    };
+
+    //estimates rows and costs from table statistics and picks the cheapest
+    //access path and join algorithm; costs are in block reads, in-memory
+    //work on a row is a small fraction of one
+    class Planner {
+    public:
+        Planner(size_t aMemory = Config::getSortMemory()) : memory(aMemory) {}
+
+        //fraction of the rows that pass the filters
+        double      selectivity(const Filters& aFilters, const TableStats& aStats) const;
+
+        //full table scan, or a scan of the primary key range the filters allow
+        ScanPlan    planScan(const Filters& aFilters, const TableStats& aStats,
+                             const std::string& aKey, IndexType aKeyType) const;
+
+        //the right side is probed, hashed or merged with the left rows
+        JoinPlan    planJoin(const JoinInput& aLeft, const JoinInput& aRight, bool anOuter) const;
+
+        static double       joinRows(const JoinInput& aLeft, const JoinInput& aRight, bool anOuter);
+        static std::string  describe(const KeyRange& aRange, const std::string& aKey);
+        static std::string  describe(JoinMethod aMethod);
+
+    protected:
+        double      sortCost(double aRows) const;
+
+        size_t      memory; //bytes a hash table or sort may hold
+    };
+
+}
+
+#endif /* Planner_hpp */
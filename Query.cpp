@@ -7,19 +7,27 @@
 
 #include <limits>
 #include "Query.hpp"
+#include "Config.hpp"
 
 namespace ECE141 {
 
-    Query::Query() : _from(nullptr), all(false), offset(0), limit(std::numeric_limits<int>::max()) {}
+    Query::Query() : _from(nullptr), all(false), distinct(false), offset(0), limit(std::numeric_limits<int>::max()),
+        parallelism(0), cancelled(std::make_shared<std::atomic<bool>>(false)) {}
 
-    Query::Query(const Query& aCopy) {
+    Query::Query(const Query& aCopy) : filters(aCopy.filters) {
         entityName = aCopy.entityName;
         _from = aCopy._from;
         fields = aCopy.fields;
         all = aCopy.all;
+        distinct = aCopy.distinct;
         offset = aCopy.offset;
         limit = aCopy.limit;
         orderBy = aCopy.orderBy;
+        ascend = aCopy.ascend;
+        aggregates = aCopy.aggregates;
+        groupBy = aCopy.groupBy;
+        parallelism = aCopy.parallelism;
+        cancelled = aCopy.cancelled;
     }
 
     Query::~Query() {}
@@ -29,10 +37,15 @@ namespace ECE141 {
         _from = aCopy._from;
         fields = aCopy.fields;
         all = aCopy.all;
+        distinct = aCopy.distinct;
         offset = aCopy.offset;
         limit = aCopy.limit;
         orderBy = aCopy.orderBy;
         ascend = aCopy.ascend;
+        aggregates = aCopy.aggregates;
+        groupBy = aCopy.groupBy;
+        parallelism = aCopy.parallelism;
+        cancelled = aCopy.cancelled;
         return *this;
     }
 
@@ -68,6 +81,41 @@ namespace ECE141 {
         return limit;
     }
 
+    const AggregateList& Query::getAggregates() const {
+        return aggregates;
+    }
+
+    StringList Query::getGroupBy() const {
+        return groupBy;
+    }
+
+    bool Query::isAggregate() const {
+        return aggregates.size() || groupBy.size();
+    }
+
+    bool Query::isDistinct() const {
+        return distinct;
+    }
+
+    StringList Query::getDistinctFields() const {
+        if (!all || !_from)
+            return fields;
+
+        StringList theFields;
+        for (auto& att : _from->getAttributes())
+            theFields.push_back(att.getName());
+        return theFields;
+    }
+
+    size_t Query::getParallelism() const {
+        return parallelism ? parallelism : Config::getParallelism();
+    }
+
+    Query& Query::setParallelism(size_t aCount) {
+        parallelism = aCount;
+        return *this;
+    }
+
     Query& Query::setEntityName(std::string aName) {
         entityName = aName;
         return *this;
@@ -111,6 +159,30 @@ namespace ECE141 {
         return *this;
     }
 
+    Query& Query::addAggregate(const Aggregate& anAggregate) {
+        aggregates.push_back(anAggregate);
+        return *this;
+    }
+
+    Query& Query::setGroupBy(std::string aField) {
+        groupBy.push_back(aField);
+        return *this;
+    }
+
+    Query& Query::setDistinct(bool aState) {
+        distinct = aState;
+        return *this;
+    }
+
+    Query& Query::clearWindow() {
+        distinct = false;
+        orderBy.clear();
+        ascend.clear();
+        offset = 0;
+        limit = std::numeric_limits<int>::max();
+        return *this;
+    }
+
     void Query::setLogic(Operators anOp) {
         filters.setLogic(anOp);
     }
@@ -122,4 +194,18 @@ namespace ECE141 {
     bool Query::matches(KeyValues& aList) {
         return filters.matches(aList);
     }
+
+    bool Query::getProjection(StringSet& aFields) const {
+        if (all)
+            return false;
+
+        aFields.insert(fields.begin(), fields.end());
+        aFields.insert(orderBy.begin(), orderBy.end());
+        aFields.insert(groupBy.begin(), groupBy.end());
+        for (auto& aggregate : aggregates)
+            aFields.insert(aggregate.field);
+        filters.collectFields(aFields);
+
+        return true;
+    }
 }
@@ -12,11 +12,14 @@
 #include <string>
 #include <optional>
 #include <vector>
+#include <memory>
+#include <atomic>
 #include "Attribute.hpp"
 #include "Row.hpp"
 #include "Entity.hpp"
 #include "Tokenizer.hpp"
 #include "Filters.hpp"
+#include "Aggregator.hpp"
 
 namespace ECE141 {
 
@@ -38,6 +41,25 @@ namespace ECE141 {
     std::vector<bool>        getAscend() const;
     int                      getOffset() const;
     int                      getLimit() const;
+    const AggregateList&     getAggregates() const;
+    StringList               getGroupBy() const;
+
+    //aggregate functions or group by turn the query into an aggregation
+    bool                     isAggregate() const;
+    bool                     isDistinct() const;
+
+    //fields a distinct query compares, the selected (or all) fields
+    StringList               getDistinctFields() const;
+
+    //workers a scan of this query may keep busy, Config::getParallelism()
+    //unless set
+    size_t                   getParallelism() const;
+    Query&                   setParallelism(size_t aCount);
+
+    //ask the running operators to stop; copies of a query share the flag
+    void                     cancel() { *cancelled = true; }
+    bool                     isCancelled() const { return *cancelled; }
+    const std::atomic<bool>* getCancelFlag() const { return cancelled.get(); }
 
     //set data
     Query& setEntityName(std::string aName);
@@ -48,11 +70,22 @@ namespace ECE141 {
     Query& setOrderBy(std::string aField, bool anAscending = true);
     Query& setOffset(int anOffset);    
     Query& setLimit(int aLimit);
+    Query& addAggregate(const Aggregate& anAggregate);
+    Query& setGroupBy(std::string aField);
+    Query& setDistinct(bool aState);
+    //drop distinct, order by, offset and limit (e.g. to scan one side of a join)
+    Query& clearWindow();
     void setLogic(Operators anOp);
 
     StatusResult parseFilters(Tokenizer& aTokenizer);
         
     bool matches(KeyValues& aList);
+    bool hasFilters() const { return filters.getCount() > 0; }
+    const Filters& getFilters() const { return filters; }
+
+    //collect the fields a scan must decode (selects, filters, order by)
+    //return false if every field is required
+    bool getProjection(StringSet& aFields) const;
 
     /*
     DBQuery& orderBy(const std::string &aField, bool ascending=false);
@@ -74,9 +107,18 @@ namespace ECE141 {
 
     //used by Database::selectRows()
     bool       all;
+    bool       distinct;
     int        offset;
     int        limit;
     Filters    filters;
+
+    //used by Database::aggregateRows()
+    AggregateList aggregates;
+    StringList    groupBy;
+
+    //used by the parallel operators
+    size_t                             parallelism; //0 for the default
+    std::shared_ptr<std::atomic<bool>> cancelled;
     
   };
 
@@ -8,6 +8,7 @@
 
 #include "Row.hpp"
 #include "Database.hpp"
+#include "Helpers.hpp"
 
 
 namespace ECE141 {
@@ -19,8 +20,11 @@ namespace ECE141 {
     }
 
     static std::ostream& operator<< (std::ostream& out, const Value& aValue) {
-        std::visit([theType = vtype(aValue), &out](auto const& aValue)
-        { out << theType << ' ' << '\"' << aValue << '\"'; }, aValue);
+        std::stringstream theText;
+        std::visit([&theText](auto const& aValue) { theText << aValue; }, aValue);
+        bool isEscaped = Helpers::needsEscape(theText.str());
+        out << (isEscaped ? Helpers::kEscapedText : vtype(aValue)) << ' ';
+        Helpers::writeQuoted(out, theText.str(), isEscaped);
         return out;
     }
 
@@ -55,14 +59,16 @@ namespace ECE141 {
     }
 
     bool Row::update(KeyValues aNewData) {
+        bool changed = false;
         for (auto& cur : aNewData) {
-            if (data.count(cur.first))
+            auto theField = data.find(cur.first);
+            if (theField == data.end() || theField->second != cur.second) {
                 data[cur.first] = cur.second;
-            else
-                return false;
+                changed = true;
+            }
         }
 
-        return true;
+        return changed;
     }
 
     void Row::addData(std::string aName, Value aValue) {
@@ -74,7 +80,11 @@ namespace ECE141 {
     }
 
 	StatusResult Row::encode(std::ostream& aWriter) {
-        aWriter << blockNumber << ' ';
+        //the version follows the block number, rows of version 0 leave it out
+        aWriter << blockNumber;
+        if (version)
+            aWriter << '@' << version;
+        aWriter << ' ';
         for (auto& cur : data) {
             //the name
             aWriter << cur.first << ' ';
@@ -86,21 +96,10 @@ namespace ECE141 {
 	}
 
     namespace DecodeHelper {
-        std::string readValue(std::istream& aReader) {
-            std::string res = "";
+        std::string readValue(std::istream& aReader, char aType) {
             aReader.get(); //skip space
             aReader.get(); //skip quote
-
-            while (!aReader.eof()) {
-                char ch = aReader.get();
-                
-                if (ch == '\"')
-                    break;
-
-                res.push_back(ch);
-            }
-
-            return res;
+            return Helpers::readQuoted(aReader, aType == Helpers::kEscapedText);
         }
     }
 
@@ -113,10 +112,16 @@ namespace ECE141 {
     }
 
 	StatusResult Row::decode(std::istream& aReader) {
+        return decode(aReader, nullptr);
+	}
+
+	StatusResult Row::decode(std::istream& aReader, const StringSet* aFields) {
         std::string temp;
 
         aReader >> temp;
         blockNumber = std::stoul(temp);
+        auto theAt = temp.find('@');
+        version = theAt == std::string::npos ? 0 : std::stoul(temp.substr(theAt + 1));
 
         while (aReader >> temp) {
             //key
@@ -126,8 +131,11 @@ namespace ECE141 {
             aReader >> temp;
             char theType = temp[0];
 
-            //value
-            temp = DecodeHelper::readValue(aReader);
+            //value, always consumed so the stream stays aligned
+            temp = DecodeHelper::readValue(aReader, theType);
+            if (aFields && !aFields->count(key))
+                continue;
+
             switch (theType) {
             case 'b':
                 data[key] = stob(temp);
@@ -139,6 +147,7 @@ namespace ECE141 {
                 data[key] = std::stod(temp);
                 break;
             case 's':
+            case Helpers::kEscapedText:
                 data[key] = temp;
                 break;
             }
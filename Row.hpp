@@ -15,6 +15,7 @@
 #include <variant>
 #include <vector>
 #include <memory>
+#include <functional>
 #include "Storage.hpp"
 #include "Attribute.hpp"
 
@@ -26,19 +27,20 @@ namespace ECE141 {
   class Row : public Storable {
   public:
 
-      Row() : blockNumber(0) {}
+      Row() : blockNumber(0), version(0) {}
 
-      Row(KeyValues aData, uint32_t aBlockNumber)
-          : data(aData), blockNumber(aBlockNumber) {}
+      Row(KeyValues aData, uint32_t aBlockNumber, uint32_t aVersion = 0)
+          : data(aData), blockNumber(aBlockNumber), version(aVersion) {}
 
       Row(const Row& aCopy)
-          : data(aCopy.data), blockNumber(aCopy.blockNumber) {}
+          : data(aCopy.data), blockNumber(aCopy.blockNumber), version(aCopy.version) {}
 
       ~Row() {}
 
       Row& operator=(const Row& aCopy) {
           data = aCopy.data;
           blockNumber = aCopy.blockNumber;
+          version = aCopy.version;
           return *this;
       }
 
@@ -50,8 +52,13 @@ namespace ECE141 {
 
       uint32_t getBlockNum();
 
+      //schema version of the table the fields were written under
+      uint32_t getVersion() const { return version; }
+      void     setVersion(uint32_t aVersion) { version = aVersion; }
+
       void setId(int anID);
       
+      //set the given fields, false if the row already held those values
       bool update(KeyValues aNewData);
 
       void addData(std::string aName, Value aValue);
@@ -61,12 +68,15 @@ namespace ECE141 {
       /*----------------Storable----------------*/
       StatusResult encode(std::ostream &aWriter) override;
       StatusResult decode(std::istream &aReader) override;
+      //decode only the given fields, skip the rest (all if null)
+      StatusResult decode(std::istream &aReader, const StringSet *aFields);
       void         initBlock(Block &aBlock);
       /*----------------Storable----------------*/
 
   protected:
       KeyValues           data;
       uint32_t            blockNumber;
+      uint32_t            version;
 
   };
 
@@ -74,6 +84,9 @@ namespace ECE141 {
 
   using RowCollection = std::vector<std::unique_ptr<Row> >;
 
+  //receives rows one at a time; return false to stop the stream
+  using RowVisitor = std::function<bool(std::unique_ptr<Row>)>;
+
 }
 
 #endif /* Row_hpp */
@@ -45,12 +45,19 @@ namespace ECE141 {
             Keywords::into_kw,
             Keywords::describe_kw,
             Keywords::insert_kw,
+            Keywords::load_kw,
             Keywords::select_kw,
+            Keywords::explain_kw,
+            Keywords::copy_kw,
+            Keywords::analyze_kw,
+            Keywords::truncate_kw,
+            Keywords::stats_kw,
             Keywords::update_kw,
             Keywords::delete_kw,
             Keywords::index_kw,
             Keywords::indexes_kw,
-            Keywords::alter_kw
+            Keywords::alter_kw,
+            Keywords::vacuum_kw
         };
 
         return theKnown.count(aKeyword);
@@ -79,8 +86,9 @@ namespace ECE141 {
         Statement* ShowStatementFactory(Tokenizer& aTokenizer) {
             //allocate a Statement and parse the input
             Statement* theStmt;
-            if (aTokenizer.peek().keyword == Keywords::tables_kw) {
-                //show tables
+            if (aTokenizer.peek().keyword == Keywords::tables_kw
+                || aTokenizer.peek().keyword == Keywords::stats_kw) {
+                //show tables, show stats
                 theStmt = new SQLStatement{};
             }
             else {
@@ -99,10 +107,40 @@ namespace ECE141 {
             return theStmt;
         }
 
-        Statement* SelectStatmentFactory(Tokenizer& aTokenizer, Database* aDB) {
-            //allocate a SelectStatement and parse the input
+        Statement* LoadStatementFactory(Tokenizer& aTokenizer) {
+            //allocate a LoadStatement and parse the input
+            LoadStatement* theStmt = new LoadStatement{};
+            theStmt->parse(aTokenizer);
+            return theStmt;
+        }
+
+        Statement* SelectStatmentFactory(Tokenizer& aTokenizer, Database* aDB, StatusResult& aResult) {
+            //allocate a SelectStatement and parse the input, none when it does not parse
             SelectStatement* theStmt = new SelectStatement{};
-            theStmt->parse(aTokenizer, aDB);
+            if (!(aResult = theStmt->parse(aTokenizer, aDB))) {
+                delete theStmt;
+                return nullptr;
+            }
+            return theStmt;
+        }
+
+        Statement* ExplainStatementFactory(Tokenizer& aTokenizer, Database* aDB, StatusResult& aResult) {
+            //allocate an ExplainStatement and parse the input, none when it does not parse
+            ExplainStatement* theStmt = new ExplainStatement{};
+            if (!(aResult = theStmt->parse(aTokenizer, aDB))) {
+                delete theStmt;
+                return nullptr;
+            }
+            return theStmt;
+        }
+
+        Statement* CopyStatementFactory(Tokenizer& aTokenizer, Database* aDB, StatusResult& aResult) {
+            //allocate a CopyStatement and parse the input, none when it does not parse
+            CopyStatement* theStmt = new CopyStatement{};
+            if (!(aResult = theStmt->parse(aTokenizer, aDB))) {
+                delete theStmt;
+                return nullptr;
+            }
             return theStmt;
         }
 
@@ -126,6 +164,13 @@ namespace ECE141 {
             theStmt->parse(aTokenizer);
             return theStmt;
         }
+
+        Statement* VacuumStatementFactory(Tokenizer& aTokenizer) {
+            //allocate a VacuumStatement and parse the input
+            VacuumStatement* theStmt = new VacuumStatement{};
+            theStmt->parse(aTokenizer);
+            return theStmt;
+        }
     }
     
     Statement* SQLProcessor::makeStatement(Tokenizer& aTokenizer, StatusResult& aResult) {
@@ -133,12 +178,18 @@ namespace ECE141 {
             {Keywords::create_kw,   [&]() { return StatementFactory::SQLStatmentFactory(aTokenizer); }},            
             {Keywords::drop_kw,     [&]() { return StatementFactory::SQLStatmentFactory(aTokenizer); }},
             {Keywords::describe_kw, [&]() { return StatementFactory::SQLStatmentFactory(aTokenizer); }},
+            {Keywords::analyze_kw,  [&]() { return StatementFactory::SQLStatmentFactory(aTokenizer); }},
+            {Keywords::truncate_kw, [&]() { return StatementFactory::SQLStatmentFactory(aTokenizer); }},
             {Keywords::show_kw,     [&]() { return StatementFactory::ShowStatementFactory(aTokenizer); }},
             {Keywords::insert_kw,   [&]() { return StatementFactory::InsertStatmentFactory(aTokenizer); }},
-            {Keywords::select_kw,   [&]() { return StatementFactory::SelectStatmentFactory(aTokenizer, theDB); }},
+            {Keywords::load_kw,     [&]() { return StatementFactory::LoadStatementFactory(aTokenizer); }},
+            {Keywords::select_kw,   [&]() { return StatementFactory::SelectStatmentFactory(aTokenizer, theDB, aResult); }},
+            {Keywords::explain_kw,  [&]() { return StatementFactory::ExplainStatementFactory(aTokenizer, theDB, aResult); }},
+            {Keywords::copy_kw,     [&]() { return StatementFactory::CopyStatementFactory(aTokenizer, theDB, aResult); }},
             {Keywords::update_kw,   [&]() { return StatementFactory::UpdateStatementFactory(aTokenizer, theDB); }},
             {Keywords::delete_kw,   [&]() { return StatementFactory::DeleteStatementFactory(aTokenizer, theDB); }},
-            {Keywords::alter_kw,    [&]() { return StatementFactory::AlterStatementFactory(aTokenizer); }}
+            {Keywords::alter_kw,    [&]() { return StatementFactory::AlterStatementFactory(aTokenizer); }},
+            {Keywords::vacuum_kw,   [&]() { return StatementFactory::VacuumStatementFactory(aTokenizer); }}
         };
 
         return theFactories[aTokenizer.current().keyword]();
@@ -201,6 +252,50 @@ namespace ECE141 {
         return result;
     }
 
+    StatusResult SQLProcessor::truncateTable(Statement* aStatement) {
+        //expecting a SQL Statement
+        auto* theStatement = static_cast<SQLStatement*>(aStatement);
+
+        StatusResult result = theDB->truncateTable(theStatement->getName());
+
+        //produce and display output
+        View theView(output);
+        theView.show([&result](std::ostream& anOutput) {
+            if (result)
+                anOutput << "Query OK, " << result.value << " rows affected ";
+            else
+                anOutput << "Query failed, table not found ";
+            });
+
+        theTimer.stop();
+        theTimer.showElapsedTime(output);
+
+        return result;
+    }
+
+    StatusResult SQLProcessor::vacuumTable(Statement* aStatement) {
+        //expecting a VacuumStatement
+        auto* theStatement = static_cast<VacuumStatement*>(aStatement);
+
+        StatusResult result = theDB->vacuum(theStatement->getName(), theStatement->getLimit());
+
+        //produce and display output
+        View theView(output);
+        theView.show([&result](std::ostream& anOutput) {
+            if (result)
+                anOutput << "Query OK, " << result.value << " rows affected ";
+            else if (result == Errors::unknownTable)
+                anOutput << "Query failed, table not found ";
+            else
+                anOutput << "Query failed, cannot write the database file ";
+            });
+
+        theTimer.stop();
+        theTimer.showElapsedTime(output);
+
+        return result;
+    }
+
     StatusResult SQLProcessor::describeTable(Statement* aStatement) {
         //expecting a SQL Statement
         auto* theStatement = static_cast<SQLStatement*>(aStatement);
@@ -228,11 +323,58 @@ namespace ECE141 {
         return StatusResult{ Errors::noError };
     }
 
+    StatusResult SQLProcessor::analyzeTable(Statement* aStatement) {
+        //expecting a SQL Statement
+        auto* theStatement = static_cast<SQLStatement*>(aStatement);
+
+        StatusResult result = theDB->analyzeTable(theStatement->getName());
+
+        //produce and display output
+        View theView(output);
+        theView.show([&result](std::ostream& anOutput) {
+            if (result)
+                anOutput << "Query OK, " << result.value << " rows analyzed ";
+            else
+                anOutput << "Query failed, table not found ";
+            });
+
+        theTimer.stop();
+        theTimer.showElapsedTime(output);
+
+        return result;
+    }
+
+    StatusResult SQLProcessor::showStats(Statement* aStatement) {
+        //expecting a SQL Statement
+        auto* theStatement = static_cast<SQLStatement*>(aStatement);
+
+        //what the planner currently knows about the table
+        Entity* theEntity = theDB->getEntity(theStatement->getName());
+        if (theEntity) {
+            StatsView theView(output);
+            theView.showStats(theEntity->getName(), theDB->getTableStats(*theEntity));
+        }
+        else {
+            View theView(output);
+            theView.show([](std::ostream& anOutput) {
+                anOutput << "Query failed, table not found ";
+                });
+        }
+
+        theTimer.stop();
+        theTimer.showElapsedTime(output);
+
+        return StatusResult{ theEntity ? Errors::noError : Errors::unknownTable };
+    }
+
     StatusResult SQLProcessor::insertRows(Statement* aStatement) {
         //expecting an Insert Statement
         auto* theStatement = static_cast<InsertStatement*>(aStatement);
 
-        StatusResult result = theDB->insertRows(theStatement->getName(), theStatement->getAttributes(), theStatement->getValues());        
+        StatusResult result = theStatement->getUpdates().empty()
+            ? theDB->insertRows(theStatement->getName(), theStatement->getAttributes(), theStatement->getValues())
+            : theDB->upsertRows(theStatement->getName(), theStatement->getAttributes(), theStatement->getValues(),
+                theStatement->getUpdates());
 
         //produce and display output
         View theView(output);
@@ -260,12 +402,8 @@ namespace ECE141 {
         std::vector<Join> joins = theStatement->getJoins();
 
         //select rows the matches the query or join
-        StatusResult result{ Errors::noError };
         RowCollection collection;
-        if (joins.size())
-            result = theDB->selectJoinRows(theQuery, joins, collection);
-        else
-            result = theDB->selectRows(theQuery, collection);
+        StatusResult result = theDB->queryRows(theQuery, joins, collection);
 
         //produce and display output
         QueryView theView(output);
@@ -284,6 +422,55 @@ namespace ECE141 {
         return result;
     }
 
+    StatusResult SQLProcessor::explainQuery(Statement* aStatement) {
+        //expecting an Explain Statement
+        auto* theStatement = static_cast<ExplainStatement*>(aStatement);
+
+        //record the plan, executing the query only for explain analyze
+        QueryPlan thePlan(theStatement->isAnalyze());
+        StatusResult result = theDB->explainRows(theStatement->getQuery(), theStatement->getJoins(), thePlan);
+
+        //produce and display output
+        PlanView theView(output);
+        if (result) {
+            theView.showPlan(thePlan);
+        }
+        else {
+            theView.show([](std::ostream& anOutput) {
+                anOutput << "Error occur when explaining query! ";
+                });
+        }
+
+        theTimer.stop();
+        theTimer.showElapsedTime(output);
+
+        return result;
+    }
+
+    StatusResult SQLProcessor::copyQuery(Statement* aStatement) {
+        //expecting a Copy Statement
+        auto* theStatement = static_cast<CopyStatement*>(aStatement);
+
+        StatusResult result = theDB->exportRows(theStatement->getQuery(), theStatement->getJoins(),
+            theStatement->getPath(), theStatement->getFormat());
+
+        //produce and display output
+        View theView(output);
+        theView.show([&](std::ostream& anOutput) {
+            if (result)
+                anOutput << "Query OK, " << result.value << " rows affected ";
+            else if (result == Errors::writeError)
+                anOutput << "Query failed, cannot write " << theStatement->getPath() << ' ';
+            else
+                anOutput << "Error occur when selecting rows! ";
+            });
+
+        theTimer.stop();
+        theTimer.showElapsedTime(output);
+
+        return result;
+    }
+
     StatusResult SQLProcessor::updateTable(Statement* aStatement) {
         //expecting an Update Statement
         auto* theStatement = static_cast<UpdateStatement*>(aStatement);
@@ -386,18 +573,50 @@ namespace ECE141 {
         return result;
     }
 
+    StatusResult SQLProcessor::loadData(Statement* aStatement) {
+        //expecting a Load Statement
+        auto* theStatement = static_cast<LoadStatement*>(aStatement);
+
+        StatusResult result = theDB->loadRows(theStatement->getName(), theStatement->getPath(), theStatement->getFormat());
+
+        //produce and display output
+        View theView(output);
+        theView.show([&](std::ostream& anOutput) {
+            if (result)
+                anOutput << "Query OK, " << result.value << " rows affected ";
+            else if (result == Errors::unknownTable)
+                anOutput << "Query failed, table not found ";
+            else if (result == Errors::readError)
+                anOutput << "Query failed, cannot read " << theStatement->getPath() << ' ';
+            else
+                anOutput << "Query failed, bad record on line " << result.value << ' ';
+            });
+
+        theTimer.stop();
+        theTimer.showElapsedTime(output);
+
+        return result;
+    }
+
     StatusResult SQLProcessor::run(Statement* aStatement, const Timer& aTimer) {
         std::unordered_map<Keywords, std::function<StatusResult()>> theMap{
             {Keywords::create_kw,   [&]() { return createTable(aStatement); }},
             {Keywords::show_kw,     [&]() { return showTables(aStatement); }},
             {Keywords::drop_kw,     [&]() { return dropTable(aStatement); }},
+            {Keywords::truncate_kw, [&]() { return truncateTable(aStatement); }},
             {Keywords::describe_kw, [&]() { return describeTable(aStatement); }},
+            {Keywords::analyze_kw,  [&]() { return analyzeTable(aStatement); }},
+            {Keywords::stats_kw,    [&]() { return showStats(aStatement); }},
             {Keywords::insert_kw,   [&]() { return insertRows(aStatement); }},
+            {Keywords::load_kw,     [&]() { return loadData(aStatement); }},
             {Keywords::select_kw,   [&]() { return showQuery(aStatement); }},
+            {Keywords::explain_kw,  [&]() { return explainQuery(aStatement); }},
+            {Keywords::copy_kw,     [&]() { return copyQuery(aStatement); }},
             {Keywords::update_kw,   [&]() { return updateTable(aStatement); }},
             {Keywords::delete_kw,   [&]() { return deleteRows(aStatement); }},
             {Keywords::index_kw,    [&]() { return showIndex(aStatement); }},
-            {Keywords::alter_kw,    [&]() { return alterTable(aStatement); }}
+            {Keywords::alter_kw,    [&]() { return alterTable(aStatement); }},
+            {Keywords::vacuum_kw,   [&]() { return vacuumTable(aStatement); }}
         };
 
         theTimer = aTimer;
@@ -32,9 +32,16 @@ namespace ECE141 {
       StatusResult createTable(Statement* aStatement);
       StatusResult showTables(Statement* aStatement);
       StatusResult dropTable(Statement* aStatement);
+      StatusResult truncateTable(Statement* aStatement);
+      StatusResult vacuumTable(Statement* aStatement);
       StatusResult describeTable(Statement* aStatement);
+      StatusResult analyzeTable(Statement* aStatement);
+      StatusResult showStats(Statement* aStatement);
       StatusResult insertRows(Statement* aStatement);
+      StatusResult loadData(Statement* aStatement);
       StatusResult showQuery(Statement* aStatement);
+      StatusResult explainQuery(Statement* aStatement);
+      StatusResult copyQuery(Statement* aStatement);
       StatusResult updateTable(Statement* aStatement);
       StatusResult deleteRows(Statement* aStatement);
       StatusResult showIndex(Statement* aStatement);
@@ -0,0 +1,144 @@
+//
+//  Scheduler.cpp
+//
+//  Created by Yunhsiu Wu on 5/27/21.
+//
+
+#include "Scheduler.hpp"
+
+namespace ECE141 {
+
+    //the scheduler and deque of the worker running on this thread
+    static thread_local Scheduler* tScheduler = nullptr;
+    static thread_local size_t tWorker = 0;
+
+    Scheduler::Scheduler(size_t aWorkerCount) : pending(0), nextWorker(0), stopping(false) {
+        aWorkerCount = aWorkerCount ? aWorkerCount : 1;
+        for (size_t i = 0; i < aWorkerCount; ++i)
+            workers.push_back(std::make_unique<Worker>());
+        for (size_t i = 0; i < aWorkerCount; ++i)
+            threads.emplace_back([this, i] { work(i); });
+    }
+
+    //the queued tasks still run before the workers exit
+    Scheduler::~Scheduler() {
+        {
+            std::lock_guard<std::mutex> theLock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    void Scheduler::submit(Task aTask) {
+        size_t theWorker = tScheduler == this
+            ? tWorker : nextWorker++ % workers.size();
+        {
+            std::lock_guard<std::mutex> theLock(mutex);
+            ++pending;
+        }
+        {
+            std::lock_guard<std::mutex> theLock(workers[theWorker]->mutex);
+            workers[theWorker]->tasks.push_back(std::move(aTask));
+        }
+        ready.notify_one();
+    }
+
+    //newest task of our own deque, else the oldest task of the others
+    bool Scheduler::take(size_t aWorker, Task& aTask) {
+        {
+            Worker& theOwn = *workers[aWorker];
+            std::lock_guard<std::mutex> theLock(theOwn.mutex);
+            if (!theOwn.tasks.empty()) {
+                aTask = std::move(theOwn.tasks.back());
+                theOwn.tasks.pop_back();
+                --pending;
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < workers.size(); ++i) {
+            Worker& theVictim = *workers[(aWorker + i) % workers.size()];
+            std::lock_guard<std::mutex> theLock(theVictim.mutex);
+            if (!theVictim.tasks.empty()) {
+                aTask = std::move(theVictim.tasks.front());
+                theVictim.tasks.pop_front();
+                --pending;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Scheduler::runPending() {
+        Task theTask;
+        if (!pending || !take(tScheduler == this ? tWorker : 0, theTask))
+            return false;
+        theTask();
+        return true;
+    }
+
+    void Scheduler::work(size_t aWorker) {
+        tScheduler = this;
+        tWorker = aWorker;
+        while (true) {
+            Task theTask;
+            if (take(aWorker, theTask)) {
+                theTask();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> theLock(mutex);
+            ready.wait(theLock, [this] { return stopping || pending > 0; });
+            if (stopping && !pending)
+                return;
+        }
+    }
+
+    TaskGroup::TaskGroup(Scheduler& aScheduler, const std::atomic<bool>* aCancel)
+        : scheduler(aScheduler), parent(aCancel), cancelled(false), outstanding(0) {}
+
+    //tasks refer to the caller's frame, never leave them behind
+    TaskGroup::~TaskGroup() {
+        cancel();
+        wait();
+    }
+
+    void TaskGroup::run(Task aTask) {
+        {
+            std::lock_guard<std::mutex> theLock(mutex);
+            ++outstanding;
+        }
+        scheduler.submit([this, theTask = std::move(aTask)] {
+            if (!isCancelled())
+                theTask();
+            std::lock_guard<std::mutex> theLock(mutex);
+            --outstanding;
+            finished.notify_all();
+        });
+    }
+
+    void TaskGroup::wait(const std::function<bool()>& aDone) {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> theLock(mutex);
+                if (aDone())
+                    return;
+            }
+            if (scheduler.runPending())
+                continue;
+
+            //nothing left to help with, our tasks are running elsewhere
+            std::unique_lock<std::mutex> theLock(mutex);
+            finished.wait(theLock, [&] { return aDone() || !outstanding; });
+            if (aDone())
+                return;
+        }
+    }
+
+    void TaskGroup::wait() {
+        wait([this] { return !outstanding; });
+    }
+
+}
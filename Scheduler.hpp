@@ -0,0 +1,88 @@
+//
+//  Scheduler.hpp
+//
+//  Created by Yunhsiu Wu on 5/27/21.
+//
+
+#ifndef Scheduler_hpp
+#define Scheduler_hpp
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+
+namespace ECE141 {
+
+    using Task = std::function<void()>;
+
+    //worker threads shared by every query; each worker keeps its own deque,
+    //runs its newest task first and steals the oldest task of another
+    //worker when it runs dry
+    class Scheduler {
+    public:
+        Scheduler(size_t aWorkerCount);
+        ~Scheduler();
+
+        Scheduler(const Scheduler&) = delete;
+        Scheduler& operator=(const Scheduler&) = delete;
+
+        //tasks submitted by a worker go to its own deque, others are dealt
+        //round robin
+        void    submit(Task aTask);
+
+        //run one queued task on the calling thread, false if there is none
+        bool    runPending();
+
+        size_t  getWorkerCount() const { return threads.size(); }
+
+    protected:
+        struct Worker {
+            std::deque<Task>    tasks;
+            std::mutex          mutex;
+        };
+
+        void    work(size_t aWorker);
+        bool    take(size_t aWorker, Task& aTask);
+
+        std::vector<std::unique_ptr<Worker>>    workers;
+        std::vector<std::thread>                threads;
+        std::mutex                              mutex; //guards sleeping and stopping
+        std::condition_variable                 ready;
+        std::atomic<size_t>                     pending; //queued, not yet taken
+        std::atomic<size_t>                     nextWorker;
+        bool                                    stopping;
+    };
+
+    //tasks of one operator; waiting helps run queued tasks, and cancel()
+    //skips the tasks not started yet while running ones poll isCancelled()
+    class TaskGroup {
+    public:
+        TaskGroup(Scheduler& aScheduler, const std::atomic<bool>* aCancel = nullptr);
+        ~TaskGroup();
+
+        void    run(Task aTask);
+
+        //block until aDone holds, aDone is checked after each task of the group
+        void    wait(const std::function<bool()>& aDone);
+        void    wait();
+
+        void    cancel() { cancelled = true; }
+        bool    isCancelled() const { return cancelled || (parent && *parent); }
+
+    protected:
+        Scheduler&                  scheduler;
+        const std::atomic<bool>*    parent; //e.g. the cancel flag of a query
+        std::atomic<bool>           cancelled;
+        size_t                      outstanding;
+        std::mutex                  mutex;
+        std::condition_variable     finished;
+    };
+
+}
+
+#endif /* Scheduler_hpp */
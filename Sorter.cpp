@@ -0,0 +1,377 @@
+//
+//  Sorter.cpp
+//
+//  Created by Yunhsiu Wu on 5/24/21.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "Sorter.hpp"
+
+namespace ECE141 {
+
+    namespace SortKey {
+        const char kMissing = 0x00;
+        const char kPresent = 0x01;
+        const char kNumber  = 0x01;
+        const char kString  = 0x02;
+
+        //helper: numeric value of bool, int or double
+        static double toNumber(const Value& aValue) {
+            switch (aValue.index()) {
+            case 0: return std::get<bool>(aValue) ? 1.0 : 0.0;
+            case 1: return std::get<int>(aValue);
+            case 2: return std::get<double>(aValue);
+            default: return 0.0;
+            }
+        }
+
+        //big-endian bits with the sign flipped, so negatives order first
+        static void appendNumber(std::string& aKey, double aNumber) {
+            if (aNumber == 0.0)
+                aNumber = 0.0; //fold -0.0 into 0.0
+
+            uint64_t theBits;
+            std::memcpy(&theBits, &aNumber, sizeof(theBits));
+            theBits = (theBits & 0x8000000000000000ull) ? ~theBits : theBits ^ 0x8000000000000000ull;
+
+            for (int shift = 56; shift >= 0; shift -= 8)
+                aKey.push_back(char((theBits >> shift) & 0xFF));
+        }
+
+        //0x00 is escaped as 0x00 0xFF and the string ends with 0x00 0x00,
+        //so a string never is a prefix of another encoded key
+        static void appendString(std::string& aKey, const std::string& aString) {
+            for (char ch : aString) {
+                aKey.push_back(ch);
+                if (ch == 0)
+                    aKey.push_back(char(0xFF));
+            }
+            aKey.push_back(0);
+            aKey.push_back(0);
+        }
+
+        void append(std::string& aKey, const Value* aValue, bool anAscending) {
+            size_t theStart = aKey.size();
+
+            if (!aValue) {
+                aKey.push_back(kMissing);
+            }
+            else {
+                aKey.push_back(kPresent);
+                if (auto* theString = std::get_if<std::string>(aValue)) {
+                    aKey.push_back(kString);
+                    appendString(aKey, *theString);
+                }
+                else {
+                    aKey.push_back(kNumber);
+                    appendNumber(aKey, toNumber(*aValue));
+                }
+            }
+
+            //descending: invert the bytes of this segment
+            if (!anAscending) {
+                for (size_t i = theStart; i < aKey.size(); ++i)
+                    aKey[i] = ~aKey[i];
+            }
+        }
+    }
+
+    std::string RowComparator::makeKey(Row& aRow) const {
+        std::string theKey;
+        KeyValues& theData = aRow.getData();
+
+        for (size_t i = 0; i < fields.size(); ++i) {
+            auto theIt = theData.find(fields[i]);
+            bool isAscending = i >= ascend.size() || ascend[i];
+            SortKey::append(theKey, theIt == theData.end() ? nullptr : &theIt->second, isAscending);
+        }
+        return theKey;
+    }
+
+    bool TopK::isBefore(const Entry& aLHS, const Entry& aRHS) {
+        int result = aLHS.key.compare(aRHS.key);
+        return result ? result < 0 : aLHS.seq < aRHS.seq;
+    }
+
+    void TopK::push(std::unique_ptr<Row> aRow) {
+        if (!count)
+            return;
+
+        Entry theEntry{ comparator.makeKey(*aRow), sequence++, std::move(aRow) };
+        if (heap.size() < count) {
+            heap.push_back(std::move(theEntry));
+            std::push_heap(heap.begin(), heap.end(), isBefore);
+        }
+        else if (isBefore(theEntry, heap.front())) {
+            //replace the current worst row
+            std::pop_heap(heap.begin(), heap.end(), isBefore);
+            heap.back() = std::move(theEntry);
+            std::push_heap(heap.begin(), heap.end(), isBefore);
+        }
+    }
+
+    void TopK::finish(RowCollection& aRows) {
+        std::sort_heap(heap.begin(), heap.end(), isBefore);
+
+        for (auto& entry : heap)
+            aRows.push_back(std::move(entry.row));
+        heap.clear();
+    }
+
+    //small ranges are cheaper to finish with a comparison sort
+    const size_t kRadixCutoff = 32;
+
+    //byte at aDepth, or -1 past the end of the key
+    static int byteAt(const SortItem& anItem, size_t aDepth) {
+        return aDepth < anItem.key.size() ? (unsigned char)anItem.key[aDepth] : -1;
+    }
+
+    static void radixSort(std::vector<SortItem>& anItems, std::vector<SortItem>& aBuffer,
+        size_t aLow, size_t aHigh, size_t aDepth) {
+        if (aHigh - aLow < kRadixCutoff) {
+            std::stable_sort(anItems.begin() + aLow, anItems.begin() + aHigh,
+                [](const SortItem& aLHS, const SortItem& aRHS) { return aLHS.key < aRHS.key; });
+            return;
+        }
+
+        //bucket 0 holds keys that already ended, 1..256 the byte values
+        size_t theStarts[258] = { 0 };
+        for (size_t i = aLow; i < aHigh; ++i)
+            ++theStarts[byteAt(anItems[i], aDepth) + 2];
+        for (size_t i = 1; i < 258; ++i)
+            theStarts[i] += theStarts[i - 1];
+
+        //stable distribution through the buffer
+        for (size_t i = aLow; i < aHigh; ++i)
+            aBuffer[aLow + theStarts[byteAt(anItems[i], aDepth) + 1]++] = std::move(anItems[i]);
+        for (size_t i = aLow; i < aHigh; ++i)
+            anItems[i] = std::move(aBuffer[i]);
+
+        //after the pass theStarts[b] is the end of bucket b
+        size_t theBegin = aLow + theStarts[0];
+        for (size_t bucket = 1; bucket < 257; ++bucket) {
+            size_t theEnd = aLow + theStarts[bucket];
+            if (theEnd - theBegin > 1)
+                radixSort(anItems, aBuffer, theBegin, theEnd, aDepth + 1);
+            theBegin = theEnd;
+        }
+    }
+
+    void sortItems(std::vector<SortItem>& anItems) {
+        std::vector<SortItem> theBuffer(anItems.size());
+        radixSort(anItems, theBuffer, 0, anItems.size(), 0);
+    }
+
+    void sortRows(RowCollection& aRows, const RowComparator& aComparator) {
+        std::vector<SortItem> theItems;
+        theItems.reserve(aRows.size());
+        for (size_t i = 0; i < aRows.size(); ++i)
+            theItems.push_back(SortItem{ aComparator.makeKey(*aRows[i]), i });
+
+        sortItems(theItems);
+
+        RowCollection theSorted;
+        theSorted.reserve(aRows.size());
+        for (auto& item : theItems)
+            theSorted.push_back(std::move(aRows[item.index]));
+        aRows.swap(theSorted);
+    }
+
+
+    //runs merged at once; more runs are merged in several passes
+    const size_t kMergeFanIn = 64;
+    const size_t kRunBufferSize = 1 << 16;
+
+    //rough in-memory footprint of a decoded row
+    static size_t estimateSize(Row& aRow) {
+        size_t theSize = sizeof(Row);
+        for (auto& cur : aRow.getData()) {
+            theSize += cur.first.size() + sizeof(Value) + 48; //map node overhead
+            if (auto* theString = std::get_if<std::string>(&cur.second))
+                theSize += theString->size();
+        }
+        return theSize;
+    }
+
+    //run record: key length, key, row length, encoded row
+    static void writeRecord(std::ostream& anOutput, const std::string& aKey, const std::string& aRow) {
+        uint32_t theSize = uint32_t(aKey.size());
+        anOutput.write((char*)&theSize, sizeof(theSize));
+        anOutput.write(aKey.data(), theSize);
+        theSize = uint32_t(aRow.size());
+        anOutput.write((char*)&theSize, sizeof(theSize));
+        anOutput.write(aRow.data(), theSize);
+    }
+
+    static bool readRecord(std::istream& anInput, std::string& aKey, std::string& aRow) {
+        uint32_t theSize = 0;
+        if (!anInput.read((char*)&theSize, sizeof(theSize)))
+            return false;
+        aKey.resize(theSize);
+        anInput.read(&aKey[0], theSize);
+        anInput.read((char*)&theSize, sizeof(theSize));
+        aRow.resize(theSize);
+        return bool(anInput.read(&aRow[0], theSize));
+    }
+
+    ExternalSorter::ExternalSorter(const RowComparator& aComparator, size_t aMemory)
+        : comparator(aComparator), memory(aMemory), used(0), position(0) {}
+
+    ExternalSorter::~ExternalSorter() {
+        for (auto& run : runs)
+            std::remove(run.c_str());
+    }
+
+    StatusResult ExternalSorter::add(std::unique_ptr<Row> aRow) {
+        std::string theKey = comparator.makeKey(*aRow);
+        used += theKey.size() + sizeof(SortItem) + estimateSize(*aRow);
+
+        items.push_back(SortItem{ std::move(theKey), rows.size() });
+        rows.push_back(std::move(aRow));
+
+        if (used > memory)
+            return spill();
+        return StatusResult{ Errors::noError };
+    }
+
+    StatusResult ExternalSorter::spill() {
+        if (items.empty())
+            return StatusResult{ Errors::noError };
+
+        sortItems(items);
+
+        std::string thePath = Config::getTempPath("sortrun");
+        std::vector<char> theBuffer(kRunBufferSize);
+        std::ofstream theRun;
+        theRun.rdbuf()->pubsetbuf(theBuffer.data(), theBuffer.size());
+        theRun.open(thePath, std::ios::binary | std::ios::trunc);
+        if (!theRun)
+            return StatusResult{ Errors::writeError };
+
+        for (auto& item : items) {
+            std::stringstream ss;
+            rows[item.index]->encode(ss);
+            writeRecord(theRun, item.key, ss.str());
+        }
+        theRun.close();
+        runs.push_back(thePath);
+
+        items.clear();
+        rows.clear();
+        used = 0;
+
+        return theRun ? StatusResult{ Errors::noError } : StatusResult{ Errors::writeError };
+    }
+
+    bool ExternalSorter::RunMerger::isLater(const Head& aLHS, const Head& aRHS) {
+        int result = aLHS.key.compare(aRHS.key);
+        return result ? result > 0 : aLHS.run > aRHS.run;
+    }
+
+    void ExternalSorter::RunMerger::open(const std::vector<std::string>& aRuns) {
+        heads.clear();
+        inputs.clear();
+        for (size_t i = 0; i < aRuns.size(); ++i) {
+            inputs.push_back(std::make_unique<std::ifstream>(aRuns[i], std::ios::binary));
+            Head theHead{ "", "", i };
+            if (readRecord(*inputs[i], theHead.key, theHead.row)) {
+                heads.push_back(std::move(theHead));
+                std::push_heap(heads.begin(), heads.end(), isLater);
+            }
+        }
+    }
+
+    bool ExternalSorter::RunMerger::next(std::string& aKey, std::string& aRow) {
+        if (heads.empty())
+            return false;
+
+        std::pop_heap(heads.begin(), heads.end(), isLater);
+        Head& theHead = heads.back();
+        aKey.swap(theHead.key);
+        aRow.swap(theHead.row);
+
+        //refill from the same run, or retire it
+        if (readRecord(*inputs[theHead.run], theHead.key, theHead.row))
+            std::push_heap(heads.begin(), heads.end(), isLater);
+        else
+            heads.pop_back();
+        return true;
+    }
+
+    StatusResult ExternalSorter::open() {
+        position = 0;
+
+        //everything fit in memory, no need to touch the disk
+        if (runs.empty()) {
+            sortItems(items);
+            return StatusResult{ Errors::noError };
+        }
+
+        StatusResult theResult = spill();
+        if (!theResult)
+            return theResult;
+
+        //reduce the run count until one merge pass can finish the sort
+        std::vector<char> theBuffer(kRunBufferSize);
+        while (runs.size() > kMergeFanIn) {
+            std::vector<std::string> theGroup(runs.begin(), runs.begin() + kMergeFanIn);
+            std::string thePath = Config::getTempPath("sortrun");
+            std::ofstream theRun;
+            theRun.rdbuf()->pubsetbuf(theBuffer.data(), theBuffer.size());
+            theRun.open(thePath, std::ios::binary | std::ios::trunc);
+
+            RunMerger theMerger;
+            theMerger.open(theGroup);
+            std::string theKey, theRow;
+            while (theMerger.next(theKey, theRow))
+                writeRecord(theRun, theKey, theRow);
+            theRun.close();
+            if (!theRun)
+                return StatusResult{ Errors::writeError };
+
+            for (auto& run : theGroup)
+                std::remove(run.c_str());
+            runs.erase(runs.begin(), runs.begin() + kMergeFanIn);
+            runs.push_back(thePath);
+        }
+
+        merger.open(runs);
+        return StatusResult{ Errors::noError };
+    }
+
+    bool ExternalSorter::next(std::unique_ptr<Row>& aRow) {
+        if (runs.empty()) {
+            if (position >= items.size())
+                return false;
+            aRow = std::move(rows[items[position++].index]);
+            return true;
+        }
+
+        std::string theKey, theRow;
+        if (!merger.next(theKey, theRow))
+            return false;
+
+        std::stringstream ss(theRow);
+        aRow = std::make_unique<Row>();
+        aRow->decode(ss);
+        return true;
+    }
+
+    StatusResult ExternalSorter::each(const RowVisitor& aVisitor) {
+        StatusResult theResult = open();
+        if (!theResult)
+            return theResult;
+
+        std::unique_ptr<Row> theRow;
+        while (next(theRow)) {
+            if (!aVisitor(std::move(theRow)))
+                break;
+        }
+        return theResult;
+    }
+
+}
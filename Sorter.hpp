@@ -0,0 +1,135 @@
+//
+//  Sorter.hpp
+//
+//  Created by Yunhsiu Wu on 5/24/21.
+//
+
+#ifndef Sorter_hpp
+#define Sorter_hpp
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <fstream>
+#include "BasicTypes.hpp"
+#include "Row.hpp"
+#include "Config.hpp"
+
+namespace ECE141 {
+
+    //normalized sort keys: byte strings that order like the typed values
+    //so two rows compare with a single memcmp
+    namespace SortKey {
+        //append one value; nullptr encodes a missing value (sorts first)
+        void append(std::string& aKey, const Value* aValue, bool anAscending = true);
+    }
+
+    //orders rows on a list of order by fields
+    class RowComparator {
+    public:
+        RowComparator(const StringList& aFields, const std::vector<bool>& anAscend)
+            : fields(aFields), ascend(anAscend) {}
+
+        //build the normalized key of a row; keys compare bytewise in the
+        //order of the rows, so each row's key is built once and the sorts
+        //compare the keys
+        std::string makeKey(Row& aRow) const;
+
+    protected:
+        StringList        fields;
+        std::vector<bool> ascend;
+    };
+
+    //keeps the first k rows of an ordering in a bounded heap
+    class TopK {
+    public:
+        TopK(const RowComparator& aComparator, size_t aCount)
+            : comparator(aComparator), count(aCount), sequence(0) {}
+
+        void push(std::unique_ptr<Row> aRow);
+
+        //move the kept rows into aRows in sorted order
+        void finish(RowCollection& aRows);
+
+    protected:
+        struct Entry {
+            std::string          key;
+            size_t               seq; //scan order, keeps ties stable
+            std::unique_ptr<Row> row;
+        };
+
+        static bool isBefore(const Entry& aLHS, const Entry& aRHS);
+
+        RowComparator      comparator;
+        size_t             count;
+        size_t             sequence;
+        std::vector<Entry> heap; //max-heap, the worst kept row on top
+    };
+
+    //a key and the position of the row it was built from
+    struct SortItem {
+        std::string key;
+        size_t      index;
+    };
+
+    //stable MSD radix sort on the normalized keys
+    void sortItems(std::vector<SortItem>& anItems);
+
+    //stable in-memory sort of the whole collection
+    void sortRows(RowCollection& aRows, const RowComparator& aComparator);
+
+    //sorts any number of rows within a memory budget: full buffers are
+    //sorted and written out as runs, then the runs are k-way merged
+    class ExternalSorter {
+    public:
+        ExternalSorter(const RowComparator& aComparator, size_t aMemory = Config::getSortMemory());
+        ~ExternalSorter();
+
+        StatusResult add(std::unique_ptr<Row> aRow);
+
+        //stream the rows in order, the visitor may stop early
+        StatusResult each(const RowVisitor& aVisitor);
+
+        //pull the rows in order instead: open() once after the last add(),
+        //then next() until it returns false
+        StatusResult open();
+        bool         next(std::unique_ptr<Row>& aRow);
+
+        size_t getRunCount() const { return runs.size(); }
+
+    protected:
+        //k-way merge over run files, ties go to the earlier run
+        class RunMerger {
+        public:
+            void open(const std::vector<std::string>& aRuns);
+            bool next(std::string& aKey, std::string& aRow);
+
+        protected:
+            struct Head {
+                std::string key;
+                std::string row;
+                size_t      run;
+            };
+            static bool isLater(const Head& aLHS, const Head& aRHS);
+
+            std::vector<Head>                           heads; //min-heap
+            std::vector<std::unique_ptr<std::ifstream>> inputs;
+        };
+
+        StatusResult spill();
+
+        RowComparator            comparator;
+        size_t                   memory; //budget in bytes
+        size_t                   used;
+        std::vector<SortItem>    items;
+        RowCollection            rows;
+        std::vector<std::string> runs; //paths of the sorted run files
+
+        size_t                   position; //next in-memory item to hand out
+        RunMerger                merger;
+    };
+
+}
+
+#endif /* Sorter_hpp */
@@ -6,6 +6,7 @@
 //  Copyright © 2019 rick gessner. All rights reserved.
 //
 
+#include <algorithm>
 #include <functional>
 #include <unordered_map>
 #include <unordered_set>
@@ -120,7 +121,8 @@ namespace ECE141 {
                             [&]() {anAtt.setDefaultValue(aTokenizer.current().data.substr(0, anAtt.getLength())); } }
                     };
 
-                    theMap[anAtt.getType()];
+                    if (theMap.count(anAtt.getType()))
+                        theMap[anAtt.getType()]();
                     aTokenizer.next();
                 }
 
@@ -278,6 +280,12 @@ namespace ECE141 {
     }
 
     StatusResult SQLStatement::parseShow(Tokenizer& aTokenizer) {
+        //show stats <table>
+        if (aTokenizer.skipIf(Keywords::stats_kw)) {
+            stmtType = Keywords::stats_kw;
+            return parseDescribe(aTokenizer);
+        }
+
         if (!aTokenizer.skipIf(Keywords::tables_kw))
             return StatusResult{ Errors::keywordExpected };
 
@@ -307,12 +315,21 @@ namespace ECE141 {
         return StatusResult{ Errors::noError };
     }
 
+    StatusResult SQLStatement::parseAnalyze(Tokenizer& aTokenizer) {
+        if (!aTokenizer.skipIf(Keywords::table_kw))
+            return StatusResult{ Errors::keywordExpected };
+
+        return parseDescribe(aTokenizer);
+    }
+
     StatusResult SQLStatement::parse(Tokenizer& aTokenizer) {
         std::unordered_map<Keywords, std::function<StatusResult()>> theMap{
             {Keywords::create_kw,   [&]() { return parseCreate(aTokenizer); }},
             {Keywords::show_kw,     [&]() { return parseShow(aTokenizer); }},
             {Keywords::drop_kw,     [&]() { return parseDrop(aTokenizer); }},
-            {Keywords::describe_kw, [&]() { return parseDescribe(aTokenizer); }}
+            {Keywords::describe_kw, [&]() { return parseDescribe(aTokenizer); }},
+            {Keywords::analyze_kw,  [&]() { return parseAnalyze(aTokenizer); }},
+            {Keywords::truncate_kw, [&]() { return parseAnalyze(aTokenizer); }}
         };
 
         stmtType = aTokenizer.current().keyword;
@@ -356,7 +373,37 @@ namespace ECE141 {
         
         return StatusResult{ Errors::noError };
     }
+
+    StatusResult VacuumStatement::parse(Tokenizer& aTokenizer) {
+        if (!aTokenizer.skipIf(Keywords::vacuum_kw))
+            return StatusResult{ Errors::keywordExpected };
+
+        if (aTokenizer.current().type == TokenType::identifier) {
+            tableName = aTokenizer.current().data;
+            aTokenizer.next();
+        }
+
+        if (aTokenizer.skipIf(Keywords::limit_kw)) {
+            if (aTokenizer.current().type != TokenType::number)
+                return StatusResult{ Errors::valueExpected };
+
+            limit = std::stoi(aTokenizer.current().data);
+            aTokenizer.next();
+        }
+
+        return StatusResult{ Errors::noError };
+    }
        
+    //words of LOAD DATA and upserts that are no keywords, so columns may use them
+    static bool skipWord(Tokenizer& aTokenizer, const std::string& aWord) {
+        std::string theWord = aTokenizer.current().data;
+        std::transform(theWord.begin(), theWord.end(), theWord.begin(), ::tolower);
+        if (aTokenizer.current().type != TokenType::identifier || theWord != aWord)
+            return false;
+        aTokenizer.next();
+        return true;
+    }
+
     StatusResult InsertStatement::parse(Tokenizer& aTokenizer) {
         if (!aTokenizer.skipIf(Keywords::insert_kw) || !aTokenizer.skipIf(Keywords::into_kw))
             return StatusResult{ Errors::keywordExpected };
@@ -391,6 +438,35 @@ namespace ECE141 {
             more = aTokenizer.skipIf(',');
         }
 
+        //ON DUPLICATE KEY UPDATE field=value|VALUES(field), ...
+        if (aTokenizer.skipIf(Keywords::on_kw)) {
+            if (!skipWord(aTokenizer, "duplicate") || !aTokenizer.skipIf(Keywords::key_kw)
+                || !aTokenizer.skipIf(Keywords::update_kw))
+                return StatusResult{ Errors::keywordExpected };
+
+            do {
+                if (aTokenizer.current().type != TokenType::identifier)
+                    return StatusResult{ Errors::identifierExpected };
+                Assignment theUpdate{ aTokenizer.current().data, "", false };
+                aTokenizer.next();
+                if (!aTokenizer.skipIf('='))
+                    return StatusResult{ Errors::operatorExpected };
+
+                theUpdate.fromRow = aTokenizer.skipIf(Keywords::values_kw);
+                if (theUpdate.fromRow && !aTokenizer.skipIf('('))
+                    return StatusResult{ Errors::punctuationExpected };
+                if (aTokenizer.current().type != TokenType::identifier &&
+                    aTokenizer.current().type != TokenType::number)
+                    return StatusResult{ Errors::unexpectedValue };
+                theUpdate.value = aTokenizer.current().data;
+                aTokenizer.next();
+                if (theUpdate.fromRow && !aTokenizer.skipIf(')'))
+                    return StatusResult{ Errors::punctuationExpected };
+
+                updates.push_back(theUpdate);
+            } while (aTokenizer.skipIf(','));
+        }
+
         /*example presentation of resulting data
         +------------+--------+--------+--------+--------+--------+
         | attributes | att_1  | att_2  | att_3  | att_4  | att_5  |
@@ -406,9 +482,94 @@ namespace ECE141 {
         return StatusResult{ Errors::noError };
     }
 
+    StatusResult LoadStatement::parse(Tokenizer& aTokenizer) {
+        if (!aTokenizer.skipIf(Keywords::load_kw) || !skipWord(aTokenizer, "data")
+            || !aTokenizer.skipIf(Keywords::from_kw))
+            return StatusResult{ Errors::keywordExpected };
+
+        if (aTokenizer.current().type != TokenType::identifier)
+            return StatusResult{ Errors::identifierExpected };
+        path = aTokenizer.current().data;
+        aTokenizer.next();
+
+        if (!aTokenizer.skipIf(Keywords::into_kw) || !aTokenizer.skipIf(Keywords::table_kw))
+            return StatusResult{ Errors::keywordExpected };
+
+        if (aTokenizer.current().type != TokenType::identifier)
+            return StatusResult{ Errors::identifierExpected };
+        tableName = aTokenizer.current().data;
+        aTokenizer.next();
+
+        //the format follows the file extension unless it is given
+        std::string theExtension = path.substr(std::min(path.rfind('.'), path.size()));
+        std::transform(theExtension.begin(), theExtension.end(), theExtension.begin(), ::tolower);
+        format = theExtension == ".json" || theExtension == ".jsonl" ? LoadFormat::json : LoadFormat::csv;
+        if (skipWord(aTokenizer, "format")) {
+            if (skipWord(aTokenizer, "csv"))
+                format = LoadFormat::csv;
+            else if (skipWord(aTokenizer, "json"))
+                format = LoadFormat::json;
+            else
+                return StatusResult{ Errors::unexpectedValue };
+        }
+
+        return StatusResult{ Errors::noError };
+    }
+
+    static std::unordered_set<Keywords> aggregateKeywords{ Keywords::avg_kw, Keywords::count_kw,
+        Keywords::max_kw, Keywords::min_kw, Keywords::sum_kw };
+
+    //e.g. count(*), sum(zipcode) or max(zipcode) as top
+    StatusResult SelectStatement::parseAggregate(Tokenizer& aTokenizer) {
+        Aggregate theAggregate{ aTokenizer.current().keyword, "", "" };
+        std::string theFunction = aTokenizer.current().data;
+        aTokenizer.next();
+
+        if (!aTokenizer.skipIf('('))
+            return StatusResult{ Errors::punctuationExpected };
+
+        if (aTokenizer.current().data == "*" && theAggregate.function == Keywords::count_kw)
+            theAggregate.field = "*";
+        else if (aTokenizer.current().type == TokenType::identifier)
+            theAggregate.field = aTokenizer.current().data;
+        else
+            return StatusResult{ Errors::identifierExpected };
+        aTokenizer.next();
+
+        if (!aTokenizer.skipIf(')'))
+            return StatusResult{ Errors::punctuationExpected };
+
+        theAggregate.name = theFunction + "(" + theAggregate.field + ")";
+        if (aTokenizer.skipIf(Keywords::as_kw)) {
+            if (aTokenizer.current().type != TokenType::identifier)
+                return StatusResult{ Errors::identifierExpected };
+            theAggregate.name = aTokenizer.current().data;
+            aTokenizer.next();
+        }
+
+        theQuery->addAggregate(theAggregate);
+        theQuery->setSelect(theAggregate.name);
+        return StatusResult{ Errors::noError };
+    }
+
+    StatusResult SelectStatement::parseGroupBy(Tokenizer& aTokenizer) {
+        do {
+            if (aTokenizer.current().type != TokenType::identifier)
+                return StatusResult{ Errors::identifierExpected };
+
+            theQuery->setGroupBy(aTokenizer.current().data);
+            aTokenizer.next();
+        } while (aTokenizer.skipIf(','));
+
+        return StatusResult{ Errors::noError };
+    }
+
     StatusResult SelectStatement::parseSelect(Tokenizer& aTokenizer) {
         if (!aTokenizer.skipIf(Keywords::select_kw))
             return StatusResult{ Errors::keywordExpected };
+
+        if (aTokenizer.skipIf(Keywords::distinct_kw))
+            theQuery->setDistinct(true);
         
         //select all
         if (aTokenizer.skipIf('*')) {
@@ -421,6 +582,14 @@ namespace ECE141 {
                 if (aTokenizer.skipIf(','))
                     continue;
 
+                //aggregate function
+                if (aggregateKeywords.count(aTokenizer.current().keyword)) {
+                    StatusResult theResult = parseAggregate(aTokenizer);
+                    if (!theResult)
+                        return theResult;
+                    continue;
+                }
+
                 if (aTokenizer.current().type != TokenType::identifier)
                     return StatusResult{ Errors::identifierExpected };
 
@@ -579,17 +748,45 @@ namespace ECE141 {
                     return theResult;
             }
             //order by clause
-            else if (aTokenizer.skipIf(Keywords::order_kw) && aTokenizer.skipIf(Keywords::by_kw)) {
+            else if (aTokenizer.skipIf(Keywords::order_kw)) {
+                if (!aTokenizer.skipIf(Keywords::by_kw))
+                    return StatusResult{ Errors::syntaxError };
                 theResult = parseOrderBy(aTokenizer);
                 if (!theResult)
                     return theResult;
             }
-            //limit clause
+            //group by clause
+            else if (aTokenizer.skipIf(Keywords::group_kw)) {
+                if (!aTokenizer.skipIf(Keywords::by_kw))
+                    return StatusResult{ Errors::syntaxError };
+                theResult = parseGroupBy(aTokenizer);
+                if (!theResult)
+                    return theResult;
+            }
+            //limit clause, also accepts "limit offset, count"
             else if (aTokenizer.skipIf(Keywords::limit_kw)) {
                 if (aTokenizer.current().type != TokenType::number)
                     return StatusResult{ Errors::valueExpected };
 
                 theQuery->setLimit(std::stoi(aTokenizer.current().data));
+                aTokenizer.next();
+
+                if (aTokenizer.skipIf(',')) {
+                    if (aTokenizer.current().type != TokenType::number)
+                        return StatusResult{ Errors::valueExpected };
+
+                    theQuery->setOffset(theQuery->getLimit());
+                    theQuery->setLimit(std::stoi(aTokenizer.current().data));
+                    aTokenizer.next();
+                }
+            }
+            //offset clause
+            else if (aTokenizer.skipIf(Keywords::offset_kw)) {
+                if (aTokenizer.current().type != TokenType::number)
+                    return StatusResult{ Errors::valueExpected };
+
+                theQuery->setOffset(std::stoi(aTokenizer.current().data));
+                aTokenizer.next();
             }
             //unknown clause, force forward
             else {
@@ -634,6 +831,66 @@ namespace ECE141 {
         return StatusResult{ Errors::noError };
     }
 
+    StatusResult ExplainStatement::parse(Tokenizer& aTokenizer, Database* aDB) {
+        if (!aTokenizer.skipIf(Keywords::explain_kw))
+            return StatusResult{ Errors::keywordExpected };
+        analyze = aTokenizer.skipIf(Keywords::analyze_kw);
+
+        StatusResult theResult = SelectStatement::parse(aTokenizer, aDB);
+        stmtType = Keywords::explain_kw;
+        return theResult;
+    }
+
+    StatusResult CopyStatement::parse(Tokenizer& aTokenizer, Database* aDB) {
+        if (!aTokenizer.skipIf(Keywords::copy_kw))
+            return StatusResult{ Errors::keywordExpected };
+        if (!aTokenizer.skipIf('('))
+            return StatusResult{ Errors::punctuationExpected };
+
+        //find the parenthesis that closes the select
+        size_t theStart = aTokenizer.size() - aTokenizer.remaining();
+        size_t theClose = theStart;
+        for (int depth = 1; theClose < aTokenizer.size(); ++theClose) {
+            Token& theToken = aTokenizer.tokenAt(theClose);
+            if (theToken.type != TokenType::punctuation)
+                continue;
+            if (theToken.data == "(")
+                ++depth;
+            else if (theToken.data == ")" && !--depth)
+                break;
+        }
+        if (theClose == aTokenizer.size())
+            return StatusResult{ Errors::punctuationExpected };
+
+        //the target after it
+        aTokenizer.next(int(theClose - theStart) + 1);
+        if (!skipWord(aTokenizer, "to"))
+            return StatusResult{ Errors::keywordExpected };
+        if (aTokenizer.current().type != TokenType::identifier)
+            return StatusResult{ Errors::identifierExpected };
+        path = aTokenizer.current().data;
+        aTokenizer.next();
+        if (skipWord(aTokenizer, "format")) {
+            if (skipWord(aTokenizer, "csv"))
+                format = ExportFormat::csv;
+            else if (skipWord(aTokenizer, "binary"))
+                format = ExportFormat::binary;
+            else
+                return StatusResult{ Errors::unexpectedValue };
+        }
+        if (aTokenizer.more() && aTokenizer.current().data != ";")
+            return StatusResult{ Errors::unexpectedValue };
+
+        //the select ends at the closing parenthesis, whatever follows it
+        //was read above and is skipped as unknown clauses
+        aTokenizer.tokenAt(theClose).data = ";";
+        aTokenizer.restart();
+        aTokenizer.next(int(theStart));
+        StatusResult theResult = SelectStatement::parse(aTokenizer, aDB);
+        stmtType = Keywords::copy_kw;
+        return theResult;
+    }
+
     StatusResult UpdateStatement::parseSet(Tokenizer& aTokenizer) {
         Entity* theEntity = theQuery->getFrom();
         while (aTokenizer.current().type != TokenType::keyword) {
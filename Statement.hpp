@@ -94,6 +94,7 @@ namespace ECE141 {
       StatusResult parseShow(Tokenizer& aTokenizer);
       StatusResult parseDrop(Tokenizer& aTokenizer);
       StatusResult parseDescribe(Tokenizer& aTokenizer);
+      StatusResult parseAnalyze(Tokenizer& aTokenizer);
 
       std::string tableName;
       AttributeList attributes;
@@ -114,6 +115,21 @@ namespace ECE141 {
   private:
       Keywords mode;
   };
+
+  //VACUUM [table] [LIMIT n]; no table name means every table
+  class VacuumStatement : public SQLStatement {
+  public:
+      VacuumStatement() : SQLStatement(Keywords::vacuum_kw), limit(0) {}
+
+      virtual ~VacuumStatement() {}
+
+      virtual StatusResult  parse(Tokenizer& aTokenizer);
+
+      size_t getLimit() { return limit; }
+
+  private:
+      size_t limit; //rows moved at most, 0 for all
+  };
   
   class InsertStatement : public Statement {
   public:
@@ -127,14 +143,38 @@ namespace ECE141 {
 
       std::vector<std::string>& getAttributes() { return attributes; }
       std::vector<std::vector<std::string>>& getValues() { return values; }
+      //the SETs of ON DUPLICATE KEY UPDATE, none for a plain insert
+      std::vector<Assignment>& getUpdates() { return updates; }
 
   protected:
       std::string entityName;
       std::vector<std::string> attributes;
       std::vector<std::vector<std::string>> values;
+      std::vector<Assignment> updates;
 
   };
   
+  //LOAD DATA FROM 'file' INTO TABLE name [FORMAT CSV|JSON]
+  class LoadStatement : public Statement {
+  public:
+      LoadStatement() : Statement(Keywords::load_kw), format(LoadFormat::csv) {}
+
+      ~LoadStatement() {}
+
+      virtual StatusResult parse(Tokenizer& aTokenizer);
+
+      virtual std::string getName() { return tableName; }
+
+      std::string getPath() { return path; }
+
+      LoadFormat getFormat() { return format; }
+
+  protected:
+      std::string tableName;
+      std::string path;
+      LoadFormat  format;
+  };
+  
   class SelectStatement : public Statement {
   public:
       SelectStatement() : Statement(Keywords::unknown_kw), theQuery(nullptr) {}
@@ -148,6 +188,8 @@ namespace ECE141 {
 
   protected:
       StatusResult parseSelect(Tokenizer& aTokenizer);
+      StatusResult parseAggregate(Tokenizer& aTokenizer);
+      StatusResult parseGroupBy(Tokenizer& aTokenizer);
       StatusResult parseEntity(Tokenizer& aTokenizer, Database* aDB);
       StatusResult parseOrderBy(Tokenizer& aTokenizer);
       StatusResult convertToRightJoin(Database* aDB, std::string& aTable, TableField& aLhs, TableField& aRhs);
@@ -158,6 +200,40 @@ namespace ECE141 {
       std::shared_ptr<Query> theQuery;
   };
 
+  //EXPLAIN [ANALYZE] followed by a select
+  class ExplainStatement : public SelectStatement {
+  public:
+      ExplainStatement() : SelectStatement(), analyze(false) {}
+
+      ~ExplainStatement() {}
+
+      virtual StatusResult parse(Tokenizer& aTokenizer, Database* aDB);
+
+      //run the query and measure each operator
+      bool isAnalyze() { return analyze; }
+
+  protected:
+      bool analyze;
+  };
+
+  //COPY (select) TO 'path' [FORMAT CSV|BINARY]
+  class CopyStatement : public SelectStatement {
+  public:
+      CopyStatement() : SelectStatement(), format(ExportFormat::csv) {}
+
+      ~CopyStatement() {}
+
+      virtual StatusResult parse(Tokenizer& aTokenizer, Database* aDB);
+
+      std::string getPath() { return path; }
+
+      ExportFormat getFormat() { return format; }
+
+  protected:
+      std::string  path;
+      ExportFormat format;
+  };
+
   class UpdateStatement : public SelectStatement {
   public:
       UpdateStatement() : SelectStatement() {}
@@ -0,0 +1,249 @@
+//
+//  Statistics.cpp
+//
+//  Created by Yunhsiu Wu on 5/29/21.
+//
+
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <sstream>
+#include "Statistics.hpp"
+#include "Helpers.hpp"
+
+namespace ECE141 {
+
+    const ColumnStats* TableStats::getColumn(const std::string& aName) const {
+        auto theColumn = columns.find(aName);
+        return theColumn != columns.end() ? &theColumn->second : nullptr;
+    }
+
+    size_t TableStats::getDistinct(const std::string& aName) const {
+        const ColumnStats* theColumn = getColumn(aName);
+        return theColumn ? theColumn->distinct : 0;
+    }
+
+    //values are written like row values: a type letter and the quoted text,
+    //text that needs escaping under its own letter
+    static void encodeValue(std::ostream& anOutput, const Value& aValue) {
+        static const char theTypes[] = { 'b', 'i', 'd', 's' };
+        std::stringstream theText;
+        std::visit([&theText](const auto& aData) { theText << aData; }, aValue);
+        bool isEscaped = Helpers::needsEscape(theText.str());
+        anOutput << (isEscaped ? Helpers::kEscapedText : theTypes[aValue.index()]) << ' ';
+        Helpers::writeQuoted(anOutput, theText.str(), isEscaped);
+        anOutput << ' ';
+    }
+
+    static bool decodeValue(std::istream& anInput, Value& aValue) {
+        char theType;
+        std::string theText;
+        if (!(anInput >> theType) || !(anInput >> std::ws) || anInput.get() != '\"')
+            return false;
+        theText = Helpers::readQuoted(anInput, theType == Helpers::kEscapedText);
+        if (!anInput)
+            return false;
+
+        switch (theType) {
+            case 'b': aValue = theText == "1"; break;
+            case 'i': aValue = std::stoi(theText); break;
+            case 'd': aValue = std::stod(theText); break;
+            default:  aValue = theText; break;
+        }
+        return true;
+    }
+
+    static void encodeOptional(std::ostream& anOutput, const std::optional<Value>& aValue) {
+        anOutput << (aValue ? 1 : 0) << ' ';
+        if (aValue)
+            encodeValue(anOutput, *aValue);
+    }
+
+    static bool decodeOptional(std::istream& anInput, std::optional<Value>& aValue) {
+        int hasValue = 0;
+        if (!(anInput >> hasValue))
+            return false;
+        if (!hasValue)
+            return true;
+        Value theValue;
+        if (!decodeValue(anInput, theValue))
+            return false;
+        aValue = theValue;
+        return true;
+    }
+
+    StatusResult TableStats::encode(std::ostream& anOutput) {
+        anOutput << rows << ' ' << columns.size() << ' ';
+        for (auto& column : columns) {
+            ColumnStats& theStats = column.second;
+            anOutput << column.first << ' ' << theStats.nulls << ' ' << theStats.distinct << ' ';
+            encodeOptional(anOutput, theStats.min);
+            encodeOptional(anOutput, theStats.max);
+            anOutput << theStats.histogram.size() << ' ';
+            for (auto& bound : theStats.histogram)
+                encodeValue(anOutput, bound);
+        }
+        return StatusResult{ Errors::noError };
+    }
+
+    StatusResult TableStats::decode(std::istream& anInput) {
+        size_t theCount = 0;
+        if (!(anInput >> rows >> theCount))
+            return StatusResult{ Errors::readError };
+
+        for (size_t i = 0; i < theCount; ++i) {
+            std::string theName;
+            ColumnStats theStats;
+            size_t theBounds = 0;
+            if (!(anInput >> theName >> theStats.nulls >> theStats.distinct)
+                || !decodeOptional(anInput, theStats.min) || !decodeOptional(anInput, theStats.max)
+                || !(anInput >> theBounds))
+                return StatusResult{ Errors::readError };
+
+            theStats.histogram.resize(theBounds);
+            for (auto& bound : theStats.histogram) {
+                if (!decodeValue(anInput, bound))
+                    return StatusResult{ Errors::readError };
+            }
+            columns[theName] = theStats;
+        }
+        return StatusResult{ Errors::noError };
+    }
+
+    //---------------------------------------------------
+
+    std::optional<int> compareValues(const Value& aLHS, const Value& aRHS) {
+        auto* theLeftString = std::get_if<std::string>(&aLHS);
+        auto* theRightString = std::get_if<std::string>(&aRHS);
+        if (theLeftString || theRightString) {
+            if (!theLeftString || !theRightString)
+                return std::nullopt;
+            return theLeftString->compare(*theRightString) < 0 ? -1 : *theLeftString == *theRightString ? 0 : 1;
+        }
+
+        auto toDouble = [](const Value& aValue) {
+            double theResult = 0;
+            std::visit([&theResult](const auto& aData) {
+                if constexpr (!std::is_same_v<std::decay_t<decltype(aData)>, std::string>)
+                    theResult = double(aData);
+                }, aValue);
+            return theResult;
+        };
+        double theLeft = toDouble(aLHS), theRight = toDouble(aRHS);
+        return theLeft < theRight ? -1 : theLeft == theRight ? 0 : 1;
+    }
+
+    //---------------------------------------------------
+
+    //spread the bits of a weak hash (std::hash of an int is the int itself)
+    static uint64_t mix(uint64_t aHash) {
+        aHash ^= aHash >> 30;
+        aHash *= 0xbf58476d1ce4e5b9ULL;
+        aHash ^= aHash >> 27;
+        aHash *= 0x94d049bb133111ebULL;
+        return aHash ^ (aHash >> 31);
+    }
+
+    //the leading bits pick a register, which keeps the longest run of
+    //leading zeros seen in the remaining bits
+    void HyperLogLog::add(const Value& aValue) {
+        uint64_t theHash = 0;
+        std::visit([&theHash](const auto& aData) {
+            theHash = std::hash<std::decay_t<decltype(aData)>>{}(aData);
+            }, aValue);
+        theHash = mix(theHash + aValue.index());
+
+        size_t theRegister = theHash >> (64 - kBits);
+        uint64_t theRest = theHash << kBits;
+        uint8_t theRank = 1;
+        while (theRank <= 64 - kBits && !(theRest & (1ULL << 63))) {
+            ++theRank;
+            theRest <<= 1;
+        }
+        registers[theRegister] = std::max(registers[theRegister], theRank);
+    }
+
+    double HyperLogLog::estimate() const {
+        double theCount = double(registers.size());
+        double theSum = 0;
+        size_t theEmpty = 0;
+        for (auto theRank : registers) {
+            theSum += std::ldexp(1.0, -int(theRank));
+            theEmpty += theRank == 0;
+        }
+
+        double theEstimate = 0.7213 / (1 + 1.079 / theCount) * theCount * theCount / theSum;
+        //few values: count the registers still empty instead
+        if (theEstimate <= 2.5 * theCount && theEmpty)
+            theEstimate = theCount * std::log(theCount / theEmpty);
+        return theEstimate;
+    }
+
+    //---------------------------------------------------
+
+    StatsCollector::StatsCollector(const StringList& aColumns, size_t aSampleSize)
+        : rows(0), sampleSize(aSampleSize), random(std::mt19937_64::default_seed) {
+        for (auto& name : aColumns) {
+            columns.emplace_back();
+            columns.back().name = name;
+        }
+    }
+
+    void StatsCollector::add(const KeyValues& aRow) {
+        ++rows;
+        for (auto& column : columns) {
+            auto theValue = aRow.find(column.name);
+            if (theValue == aRow.end()) {
+                ++column.nulls;
+                continue;
+            }
+
+            const Value& theData = theValue->second;
+            ++column.values;
+            column.distinct.add(theData);
+            if (!column.min || compareValues(theData, *column.min).value_or(0) < 0)
+                column.min = theData;
+            if (!column.max || compareValues(theData, *column.max).value_or(0) > 0)
+                column.max = theData;
+
+            //every value ends up in the sample with the same chance
+            if (column.sample.size() < sampleSize)
+                column.sample.push_back(theData);
+            else {
+                size_t theSlot = random() % column.values;
+                if (theSlot < sampleSize)
+                    column.sample[theSlot] = theData;
+            }
+        }
+    }
+
+    TableStats StatsCollector::finish(size_t aBucketCount) {
+        TableStats theStats;
+        theStats.rows = rows;
+        for (auto& column : columns) {
+            ColumnStats& theColumn = theStats.columns[column.name];
+            theColumn.nulls = column.nulls;
+            theColumn.distinct = std::min(column.values, size_t(std::llround(column.distinct.estimate())));
+            if (column.values && !theColumn.distinct)
+                theColumn.distinct = 1;
+            theColumn.min = column.min;
+            theColumn.max = column.max;
+
+            //bucket bounds at even steps through the sorted sample
+            std::vector<Value>& theSample = column.sample;
+            size_t theBuckets = std::min(aBucketCount, theSample.size());
+            if (!theBuckets)
+                continue;
+            std::sort(theSample.begin(), theSample.end(), [](const Value& aLHS, const Value& aRHS) {
+                return compareValues(aLHS, aRHS).value_or(0) < 0;
+                });
+            theColumn.histogram.push_back(*column.min);
+            for (size_t i = 1; i < theBuckets; ++i)
+                theColumn.histogram.push_back(theSample[(i * theSample.size() + theBuckets - 1) / theBuckets - 1]);
+            theColumn.histogram.push_back(*column.max);
+        }
+        return theStats;
+    }
+
+}
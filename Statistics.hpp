@@ -0,0 +1,95 @@
+//
+//  Statistics.hpp
+//
+//  Created by Yunhsiu Wu on 5/29/21.
+//
+
+#ifndef Statistics_hpp
+#define Statistics_hpp
+
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+#include <random>
+#include "BasicTypes.hpp"
+#include "Storage.hpp"
+
+namespace ECE141 {
+
+    //what the planner knows about a column
+    struct ColumnStats {
+        size_t               nulls = 0;    //rows without a value
+        size_t               distinct = 0; //0 when unknown
+        std::optional<Value> min;
+        std::optional<Value> max;
+        //equi-depth bucket bounds from min to max, each bucket holds about
+        //the same number of rows; empty until the table is analyzed
+        std::vector<Value>   histogram;
+    };
+
+    //what the planner knows about a table, ANALYZE TABLE stores it next to
+    //the table's entity block
+    struct TableStats : public Storable {
+        size_t                              rows = 0;
+        std::map<std::string, ColumnStats>  columns;
+
+        const ColumnStats* getColumn(const std::string& aName) const;
+        //distinct values of a column, 0 when unknown
+        size_t             getDistinct(const std::string& aName) const;
+
+        /*----------------Storable----------------*/
+        StatusResult    encode(std::ostream& anOutput) override;
+        StatusResult    decode(std::istream& anInput) override;
+        /*----------------Storable----------------*/
+    };
+
+    //numeric values compare as numbers, strings as strings; nothing otherwise
+    std::optional<int> compareValues(const Value& aLHS, const Value& aRHS);
+
+    //estimates the number of distinct values in a few kilobytes
+    class HyperLogLog {
+    public:
+        HyperLogLog() : registers(size_t(1) << kBits, 0) {}
+
+        void    add(const Value& aValue);
+        double  estimate() const;
+
+    protected:
+        static const size_t kBits = 11; //2048 registers, about 2% error
+
+        std::vector<uint8_t> registers;
+    };
+
+    //gathers the statistics of a table from its rows: exact null counts and
+    //min/max, distinct estimates, and histograms from a reservoir sample
+    class StatsCollector {
+    public:
+        StatsCollector(const StringList& aColumns, size_t aSampleSize = kSampleSize);
+
+        void        add(const KeyValues& aRow);
+        TableStats  finish(size_t aBucketCount = kBucketCount);
+
+        static const size_t kSampleSize = 10000;
+        static const size_t kBucketCount = 16;
+
+    protected:
+        struct Column {
+            std::string          name;
+            size_t               nulls = 0;
+            size_t               values = 0; //non-null values seen
+            HyperLogLog          distinct;
+            std::optional<Value> min;
+            std::optional<Value> max;
+            std::vector<Value>   sample;
+        };
+
+        std::vector<Column> columns;
+        size_t              rows;
+        size_t              sampleSize;
+        std::mt19937_64     random;
+    };
+
+}
+
+#endif /* Statistics_hpp */
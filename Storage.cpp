@@ -11,6 +11,7 @@
 #include <cstdlib>
 #include <optional>
 #include <cstring>
+#include <algorithm>
 #include "Storage.hpp"
 #include "Config.hpp"
 
@@ -46,87 +47,218 @@ namespace ECE141 {
   }
   
   uint32_t Storage::getFreeBlock() {
-      uint32_t res = getBlockCount();
+      return getFreeBlocks(1).front();
+  }
 
-      if (!available.empty()) { //pop an empty block number if there are any
-          res = *available.begin();
-          available.erase(res);          
+  std::vector<uint32_t> Storage::getFreeBlocks(size_t aCount) {
+      std::vector<uint32_t> theBlocks;
+      theBlocks.reserve(aCount);
+      //blocks handed out but not written yet count as part of the file,
+      //the last entry of the available list marks where new blocks start
+      uint32_t theEnd = getBlockCount();
+      if (!available.empty() && *available.rbegin() > theEnd)
+          theEnd = *available.rbegin();
+
+      //free blocks inside the file; the ones at its end only mark the end
+      while (theBlocks.size() < aCount && !available.empty() && *available.begin() < theEnd) {
+          theBlocks.push_back(*available.begin());
+          available.erase(available.begin());
       }
 
-      if (available.empty()) { //put the next empty block into available
-          available.insert(getBlockCount() + 1);
+      uint32_t theNext = theEnd;
+      while (theBlocks.size() < aCount)
+          theBlocks.push_back(theNext++);
+
+      //the block after the run becomes the next new one
+      available.erase(available.lower_bound(theEnd), available.end());
+      available.insert(theNext);
+      return theBlocks;
+  }
+
+  std::vector<uint32_t> Storage::getFreeRun(size_t aCount, uint32_t aBefore) {
+      if (!aCount)
+          return {};
+      uint32_t theEnd = getBlockCount();
+      if (!available.empty() && *available.rbegin() > theEnd)
+          theEnd = *available.rbegin();
+
+      //the first run inside the file that is long enough
+      uint32_t theStart = 0;
+      size_t theLength = 0;
+      for (auto theBlock : available) {
+          if (theBlock >= theEnd)
+              break;
+          if (theLength && theBlock == theStart + theLength)
+              ++theLength;
+          else {
+              theStart = theBlock;
+              theLength = 1;
+          }
+          if (theLength == aCount)
+              break;
       }
 
-      return res;
+      std::vector<uint32_t> theBlocks;
+      if (theLength < aCount)
+          theStart = theEnd;
+      if (theStart + aCount > aBefore)
+          return theBlocks;
+      if (theStart == theEnd) {
+          available.erase(available.lower_bound(theEnd), available.end());
+          available.insert(uint32_t(theEnd + aCount));
+      }
+      for (uint32_t theBlock = theStart; theBlock < theStart + aCount; ++theBlock) {
+          theBlocks.push_back(theBlock);
+          available.erase(theBlock);
+      }
+      return theBlocks;
+  }
+
+  void Storage::setFreeBlocks(const std::vector<uint32_t>& aBlocks) {
+      available = BlockList(aBlocks.begin(), aBlocks.end());
+      available.insert(getBlockCount());
+  }
+
+  uint32_t Storage::trimFreeBlocks() {
+      uint32_t theEnd = getBlockCount();
+      while (theEnd && available.count(theEnd - 1))
+          --theEnd;
+      available.erase(available.lower_bound(theEnd), available.end());
+      available.insert(theEnd);
+      return theEnd;
+  }
+
+  void Storage::returnBlocks(const std::vector<uint32_t>& aBlocks) {
+      if (available.empty() || aBlocks.empty())
+          return;
+      //the blocks lie below the end marker, which moves down over the ones
+      //that were never part of the file
+      uint32_t theCount = getBlockCount();
+      uint32_t theEnd = *available.rbegin();
+      available.insert(aBlocks.begin(), aBlocks.end());
+      available.erase(theEnd);
+      while (theEnd > theCount && available.count(theEnd - 1))
+          available.erase(--theEnd);
+      available.insert(theEnd);
   }
 
   StatusResult Storage::markBlockAsFree(uint32_t aPos) {
       return releaseBlocks(aPos);
   }
 
+  std::vector<uint32_t> Storage::getChain(uint32_t aPos) {
+      std::vector<uint32_t> theChain{ aPos };
+      uint32_t theCount = getBlockCount();
+      Block theFirst, theBlock;
+      if (aPos >= theCount || !readBlock(aPos, theFirst))
+          return theChain;
+
+      //follow the links while they continue this chain, a stale link must
+      //not hand out a block that belongs to something else
+      std::set<uint32_t> theSeen{ aPos };
+      theBlock = theFirst;
+      while (theBlock.header.next && theBlock.header.next < theCount && !theSeen.count(theBlock.header.next)) {
+          uint32_t theNext = theBlock.header.next;
+          if (!readBlock(theNext, theBlock) || theBlock.header.type != theFirst.header.type
+              || theBlock.header.refId != theFirst.header.refId
+              || theBlock.header.pos != uint8_t(theChain.size() + theFirst.header.pos))
+              break;
+          theChain.push_back(theNext);
+          theSeen.insert(theNext);
+      }
+      return theChain;
+  }
+
   StatusResult Storage::releaseBlocks(uint32_t aPos,bool aInclusive) {
-      Block theBlock;
-      Block freeBlock(BlockType::free_block);
-      bool more = true;
+      return freeBlocks(getChain(aPos));
+  }
 
-      while (more) {
-          //read the block and get next block number
-          readBlock(aPos, theBlock);
-          auto nextPos = theBlock.header.next;
-          
-          //overwrite the block as free
-          writeBlock(aPos, freeBlock);
-
-          //insert into available list
-          available.insert(aPos);
-
-          aPos = nextPos;
-          more = aPos; //if aPos = 0 implies no next block
+  //free blocks written per run at most
+  const size_t kFreeBatch = 256;
+
+  StatusResult Storage::freeBlocks(std::vector<uint32_t> aBlocks) {
+      std::sort(aBlocks.begin(), aBlocks.end());
+      aBlocks.erase(std::unique(aBlocks.begin(), aBlocks.end()), aBlocks.end());
+
+      //overwrite the blocks as free and put them into available list
+      std::vector<Block> theRun(std::min(aBlocks.size(), kFreeBatch), Block(BlockType::free_block));
+      StatusResult theResult{ Errors::noError };
+      for (size_t i = 0; i < aBlocks.size() && theResult; ) {
+          size_t theCount = 1;
+          while (i + theCount < aBlocks.size() && theCount < kFreeBatch
+              && aBlocks[i + theCount] == aBlocks[i] + theCount)
+              ++theCount;
+          theResult = writeBlocks(aBlocks[i], theRun.data(), theCount);
+          i += theCount;
       }
-      
-      return StatusResult{Errors::noError};
+      available.insert(aBlocks.begin(), aBlocks.end());
+
+      return theResult;
+  }
+
+  //blocks read per run when looking for the blocks of an owner
+  const size_t kScanBatch = 256;
+
+  std::vector<uint32_t> Storage::getOwnedBlocks(uint32_t aRefId, BlockType aType) {
+      std::vector<uint32_t> theBlocks;
+      std::vector<Block> theRun(kScanBatch);
+      uint32_t theCount = getBlockCount();
+      for (uint32_t theStart = 0; theStart < theCount; theStart += kScanBatch) {
+          size_t theSize = std::min<size_t>(kScanBatch, theCount - theStart);
+          if (!readBlocks(theStart, theRun.data(), theSize))
+              break;
+          for (size_t i = 0; i < theSize; ++i) {
+              const BlockHeader& theHeader = theRun[i].header;
+              if (theHeader.type == char(aType) && theHeader.refId == aRefId)
+                  theBlocks.push_back(theStart + uint32_t(i));
+          }
+      }
+      return theBlocks;
   }
 
   StatusResult Storage::save(std::iostream &aStream, StorageInfo &anInfo) {      
       size_t streamSize = anInfo.size;
 
-      size_t blockIndex = 0;
-      if (anInfo.start == kNewBlock)
-          blockIndex = getFreeBlock();
-      else
-          blockIndex = anInfo.start;
-
-      size_t pos = 0;
       size_t blockCount = anInfo.size / kPayloadSize;
-      if (anInfo.size % kPayloadSize) //one more block required
+      if (anInfo.size % kPayloadSize || !blockCount) //one more block required
           ++blockCount;
 
-      while (pos < blockCount) {
+      //rewriting keeps the blocks of the old chain, the rest are new, and
+      //the old blocks left over are freed
+      std::vector<uint32_t> theBlocks;
+      if (anInfo.start != kNewBlock)
+          theBlocks = getChain(anInfo.start);
+      std::vector<uint32_t> theLeftover;
+      if (theBlocks.size() > blockCount) {
+          theLeftover.assign(theBlocks.begin() + blockCount, theBlocks.end());
+          theBlocks.resize(blockCount);
+      }
+      else if (theBlocks.size() < blockCount) {
+          auto theMore = getFreeBlocks(blockCount - theBlocks.size());
+          theBlocks.insert(theBlocks.end(), theMore.begin(), theMore.end());
+      }
+
+      for (size_t pos = 0; pos < blockCount; ++pos) {
           //set up block
           Block theBlock(anInfo.type);
           theBlock.header = BlockHeader(anInfo.type);
           theBlock.header.pos = pos;
           theBlock.header.count = blockCount;
           theBlock.header.refId = anInfo.refId;
-          theBlock.header.next = available.size() > 0 ? *available.begin() : getBlockCount();
+          theBlock.header.next = pos + 1 < blockCount ? theBlocks[pos + 1] : 0;
           theBlock.header.size = streamSize >= kPayloadSize ? kPayloadSize : streamSize;
           theBlock.header.id = anInfo.id;
 
-          if (pos + 1 == blockCount) { //no next block 
-              available.insert(theBlock.header.next);
-              theBlock.header.next = 0;
-          }
-
-          if (streamSize >= kPayloadSize)
-              aStream.read(theBlock.payload, kPayloadSize);
-          else
-              aStream.read(theBlock.payload, streamSize);
+          aStream.read(theBlock.payload, theBlock.header.size);
+          writeBlock(theBlocks[pos], theBlock);
 
-          writeBlock(blockIndex, theBlock);
+          streamSize -= theBlock.header.size;
+      }
 
-          streamSize -= kPayloadSize;
-          ++pos;
-          blockIndex = theBlock.header.next;
+      Block freeBlock(BlockType::free_block);
+      for (auto thePos : theLeftover) {
+          writeBlock(thePos, freeBlock);
+          available.insert(thePos);
       }
             
       return StatusResult{Errors::noError};
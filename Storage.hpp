@@ -14,6 +14,8 @@
 #include <deque>
 #include <set>
 #include <functional>
+#include <streambuf>
+#include <vector>
 #include "BlockIO.hpp"
 #include "Errors.hpp"
 
@@ -38,6 +40,16 @@ namespace ECE141 {
     virtual StatusResult  decode(std::istream &anInput)=0;
   };
 
+  //an output buffer over a block payload, so a Storable can be encoded
+  //straight into the block it is written with; fails once the payload is full
+  class PayloadBuffer : public std::streambuf {
+  public:
+    PayloadBuffer() { reset(nullptr); }
+
+    void    reset(char *aPayload) { setp(aPayload, aPayload ? aPayload + kPayloadSize : nullptr); }
+    size_t  size() const { return pptr() - pbase(); }
+  };
+
   struct StorageInfo {
     
     StorageInfo(size_t aRefId, size_t theSize, int32_t aStartPos=kNewBlock, BlockType aType=BlockType::data_block, size_t anID = 0)
@@ -66,6 +78,38 @@ namespace ECE141 {
     //get next free block number, but leave it in the list
     uint32_t     getNextFreeBlockNum();
 
+    //take aCount blocks at once: freed blocks first (ascending), then one
+    //consecutive run at the end of the file
+    std::vector<uint32_t> getFreeBlocks(size_t aCount);
+
+    //take aCount consecutive blocks: the lowest run of freed blocks long
+    //enough, or a run at the end of the file; none when the run would not
+    //end before aBefore
+    std::vector<uint32_t> getFreeRun(size_t aCount, uint32_t aBefore = UINT32_MAX);
+
+    //replace the free list with aBlocks, the blocks of the file nothing
+    //refers to; they are not written
+    void         setFreeBlocks(const std::vector<uint32_t>& aBlocks);
+
+    //the number of blocks the file needs once the free ones at its end are
+    //cut off; they leave the free list
+    uint32_t     trimFreeBlocks();
+
+    //give back blocks taken by getFreeBlocks or getFreeRun and never
+    //written; blocks taken from the end of the file move the end back
+    void         returnBlocks(const std::vector<uint32_t>& aBlocks);
+
+    //free many blocks at once: they are sorted and overwritten in runs of
+    //consecutive blocks, one seek and flush per run
+    StatusResult freeBlocks(std::vector<uint32_t> aBlocks);
+
+    //the blocks of aType whose header names aRefId as their owner, found
+    //from the headers alone by reading the file in runs of blocks
+    std::vector<uint32_t> getOwnedBlocks(uint32_t aRefId, BlockType aType);
+
+    //the blocks of the chain that starts at aPos, in chain order
+    std::vector<uint32_t> getChain(uint32_t aPos);
+
   protected:
   
     StatusResult releaseBlocks(uint32_t aPos, bool aInclusive=false);
@@ -13,8 +13,13 @@
 #include <sstream>
 #include "Errors.hpp"
 #include "Faked.hpp"
+#include "Scheduler.hpp"
+#include "Exporter.hpp"
+#include "Row.hpp"
 #include <sstream>
 #include <algorithm>
+#include <fstream>
+#include <cstdio>
 #include <map>
 #include <vector>
 #include <cctype>
@@ -523,6 +528,456 @@ namespace ECE141 {
       return theResult;
     }
 
+    bool doRewriteTest() {
+
+      std::string theDBName1(getRandomDBName('R'));
+      std::string theDBName2(getRandomDBName('R'));
+      std::string theLongBody(2500, 'x');
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "create database " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "create table Notes (id int NOT NULL auto_increment primary key, "
+                 << "title varchar(20), body varchar(3000));\n";
+      theStream1 << "INSERT INTO Notes (title, body) VALUES ";
+      for(size_t i=0;i<50;i++) {
+        theStream1 << (i ? "," : "") << "(\"note" << i+1 << "\",\"" << Fake::People::first_name() << "\")";
+      }
+      theStream1 << ";\n";
+
+      //rows 10 and 20 outgrow their block, 20 shrinks back and frees its
+      //chain to the rows inserted after it; row 30 takes a new key
+      theStream1 << "update Notes set body=\"" << theLongBody << "\" where id=10;\n";
+      theStream1 << "update Notes set body=\"" << theLongBody << "\" where id=20;\n";
+      theStream1 << "update Notes set body=\"short\" where id=20;\n";
+      theStream1 << "update Notes set id=500 where id=30;\n";
+      theStream1 << "INSERT INTO Notes (title, body) VALUES (\"after\",\"a\"),(\"after\",\"b\"),(\"after\",\"c\");\n";
+      theStream1 << "use " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "select id, body from Notes where id=10;\n";
+      theStream1 << "select id, body from Notes where id=20;\n";
+      theStream1 << "select id from Notes where id>45;\n";
+      theStream1 << "select title from Notes where id=500;\n";
+      theStream1 << "select id from Notes where id=30;\n";
+      theStream1 << "quit;\n";
+
+      //a key another row holds is refused
+      std::stringstream theStream2;
+      theStream2 << "use " << theDBName1 << ";\n";
+      theStream2 << "update Notes set id=40 where id=41;\n";
+      std::stringstream theStream3;
+      theStream3 << "use " << theDBName1 << ";\n";
+      theStream3 << "select title from Notes where id=40;\n";
+      theStream3 << "select title from Notes where id=41;\n";
+      theStream3 << "drop database " << theDBName1 << ";\n";
+      theStream3 << "drop database " << theDBName2 << ";\n";
+      theStream3 << "quit;\n";
+
+      std::stringstream theOutput1, theOutput2, theOutput3;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      theResult=!doScriptTest(theStream2,theOutput2) && theResult;
+      theResult=doScriptTest(theStream3,theOutput3) && theResult;
+      output << theOutput1.str() << theOutput2.str() << theOutput3.str();
+
+      auto theTables=getTables(theOutput1.str());
+      auto theChecks=getTables(theOutput3.str());
+      theResult=theResult && theTables.size()==5 && theChecks.size()==2;
+      if(theResult) {
+        theResult=getColumn(theTables[0], 1)==StringList{theLongBody}
+          && getColumn(theTables[1], 1)==StringList{"short"}
+          && getColumn(theTables[2], 0)==StringList{"46","47","48","49","50","500","501","502","503"}
+          && getColumn(theTables[3], 0)==StringList{"note30"}
+          && getColumn(theTables[4], 0).empty()
+          && getColumn(theChecks[0], 0)==StringList{"note40"}
+          && getColumn(theChecks[1], 0)==StringList{"note41"};
+      }
+      return theResult;
+    }
+
+    bool doBulkDeleteTest() {
+
+      std::string theDBName1(getRandomDBName('B'));
+      std::string theDBName2(getRandomDBName('B'));
+      std::string theLongBody(2500, 'y');
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "create database " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "create table Notes (id int NOT NULL auto_increment primary key, "
+                 << "title varchar(20), body varchar(3000));\n";
+      for(size_t theInsert=0;theInsert<2;theInsert++) {
+        theStream1 << "INSERT INTO Notes (title, body) VALUES ";
+        for(size_t i=0;i<300;i++) {
+          theStream1 << (i ? "," : "") << "(\"" << (i%3 ? "keep" : "drop") << "\",\"" << Fake::People::first_name() << "\")";
+        }
+        theStream1 << ";\n";
+      }
+
+      //chained rows on both sides of the deleted range
+      theStream1 << "update Notes set body=\"" << theLongBody << "\" where id=100;\n";
+      theStream1 << "update Notes set body=\"" << theLongBody << "\" where id=500;\n";
+      theStream1 << "delete from Notes where id<401;\n";
+      theStream1 << "delete from Notes where title=\"drop\";\n";
+
+      //new rows take the freed blocks, the chain of row 500 stays whole
+      theStream1 << "INSERT INTO Notes (title, body) VALUES ";
+      for(size_t i=0;i<450;i++) {
+        theStream1 << (i ? "," : "") << "(\"new\",\"" << Fake::People::first_name() << "\")";
+      }
+      theStream1 << ";\n";
+      theStream1 << "use " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "select count(*) from Notes;\n";
+      theStream1 << "select id from Notes where id<410;\n";
+      theStream1 << "select body from Notes where id=500;\n";
+      theStream1 << "select count(*) from Notes where title=\"new\";\n";
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "drop database " << theDBName2 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==4;
+      if(theResult) {
+        //of rows 401..600, every third from 403 on was dropped
+        theResult=getColumn(theTables[0], 0)==StringList{"584"}
+          && getColumn(theTables[1], 0)==StringList{"401","402","404","405","407","408"}
+          && getColumn(theTables[2], 0)==StringList{theLongBody}
+          && getColumn(theTables[3], 0)==StringList{"450"};
+      }
+      return theResult;
+    }
+
+    bool doTruncateTest() {
+
+      std::string theDBName1(getRandomDBName('T'));
+      std::string theLongBody(2500, 'z');
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      addUsersTable(theStream1);
+      insertUsers(theStream1,0,5);
+      theStream1 << "create table Notes (id int NOT NULL auto_increment primary key, "
+                 << "title varchar(20), body varchar(3000));\n";
+      theStream1 << "INSERT INTO Notes (title, body) VALUES ";
+      for(size_t i=0;i<300;i++) {
+        theStream1 << (i ? "," : "") << "(\"note\",\"" << Fake::People::first_name() << "\")";
+      }
+      theStream1 << ";\n";
+      theStream1 << "update Notes set body=\"" << theLongBody << "\" where id=7;\n";
+      theStream1 << "analyze table Notes;\n";
+
+      //the rows go, the table and its increment stay
+      theStream1 << "truncate table Notes;\n";
+      theStream1 << "dump database " << theDBName1 << ";\n";
+      theStream1 << "INSERT INTO Notes (title, body) VALUES (\"again\",\"" << theLongBody << "\"),(\"again\",\"short\");\n";
+      theStream1 << "select id, title from Notes;\n";
+      theStream1 << "select count(*) from Users;\n";
+
+      //dropping releases the index and the entity too
+      theStream1 << "drop table Notes;\n";
+      theStream1 << "dump database " << theDBName1 << ";\n";
+      theStream1 << "show tables;\n";
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      auto countOf=[](const StringList& aTypes, const std::string& aType) {
+        return std::count(aTypes.begin(), aTypes.end(), aType);
+      };
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==5
+        && theOutput1.str().find("Query OK, 300 rows affected")!=std::string::npos;
+      if(theResult) {
+        //only the 5 users keep data blocks, the 302 blocks of the notes are free
+        auto theTypes=getColumn(theTables[0], 0);
+        auto theDropped=getColumn(theTables[3], 0);
+        theResult=countOf(theTypes, "data")==5 && countOf(theTypes, "free")>=302
+          && countOf(theTypes, "stats")==0 && countOf(theTypes, "entity")==2
+          && getColumn(theTables[1], 0)==StringList{"301","302"}
+          && getColumn(theTables[2], 0)==StringList{"5"}
+          && countOf(theDropped, "data")==5 && countOf(theDropped, "entity")==1
+          && countOf(theTypes, "index")==2 && countOf(theDropped, "index")==1
+          && getColumn(theTables[4], 0)==StringList{"Users"};
+      }
+      return theResult;
+    }
+
+    bool doSchemaTest() {
+
+      std::string theDBName1(getRandomDBName('V'));
+      std::string theDBName2(getRandomDBName('V'));
+      std::string theLongBody(2500, 'w');
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "create database " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "create table Notes (id int NOT NULL auto_increment primary key, "
+                 << "title varchar(20), body varchar(3000));\n";
+      theStream1 << "INSERT INTO Notes (title, body) VALUES ";
+      for(size_t i=0;i<300;i++) {
+        theStream1 << (i ? "," : "") << "(\"note\",\"" << Fake::People::first_name() << "\")";
+      }
+      theStream1 << ";\n";
+      theStream1 << "update Notes set body=\"" << theLongBody << "\" where id=7;\n";
+
+      //none of these touch the rows; body comes back as a new, empty column
+      theStream1 << "ALTER TABLE Notes add rating int default 5;\n";
+      theStream1 << "ALTER TABLE Notes drop body;\n";
+      theStream1 << "ALTER TABLE Notes add body varchar(10);\n";
+      theStream1 << "select id, rating, body from Notes where id<3;\n";
+      theStream1 << "update Notes set rating=9 where id=2;\n";
+      theStream1 << "update Notes set body=\"short\" where id=7;\n";
+      theStream1 << "INSERT INTO Notes (title) VALUES (\"new\");\n";
+
+      //the schema versions survive closing the database
+      theStream1 << "use " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "select rating from Notes where id=2;\n";
+      theStream1 << "select count(*) from Notes where rating=5;\n";
+      theStream1 << "select body from Notes where id=7;\n";
+      theStream1 << "select count(*) from Notes where body=\"short\";\n";
+      theStream1 << "drop database " << theDBName2 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      //the primary key cannot go, nor can a column be added twice
+      std::stringstream theStream2;
+      theStream2 << "use " << theDBName1 << ";\n";
+      theStream2 << "ALTER TABLE Notes drop id;\n";
+      std::stringstream theStream3;
+      theStream3 << "use " << theDBName1 << ";\n";
+      theStream3 << "ALTER TABLE Notes add rating int;\n";
+      std::stringstream theStream4;
+      theStream4 << "drop database " << theDBName1 << ";\n";
+      theStream4 << "quit;\n";
+      std::stringstream theOutput2;
+      bool theFailed=!doScriptTest(theStream2,theOutput2) && !doScriptTest(theStream3,theOutput2);
+      doScriptTest(theStream4,theOutput2);
+      output << theOutput2.str();
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theFailed && theTables.size()==5;
+      if(theResult) {
+        theResult=getColumn(theTables[0], 1)==StringList{"5","5"}
+          && getColumn(theTables[0], 2)==StringList{"NULL","NULL"}
+          && getColumn(theTables[1], 0)==StringList{"9"}
+          && getColumn(theTables[2], 0)==StringList{"300"}
+          && getColumn(theTables[3], 0)==StringList{"short"}
+          && getColumn(theTables[4], 0)==StringList{"1"};
+      }
+      return theResult;
+    }
+
+    bool doUpsertTest() {
+
+      std::string theDBName1(getRandomDBName('U'));
+      std::string theDBName2(getRandomDBName('U'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "create database " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "create table Notes (id int NOT NULL auto_increment primary key, "
+                 << "title varchar(20), hits int);\n";
+      theStream1 << "INSERT INTO Notes (title, hits) VALUES (\"one\",1),(\"two\",1),(\"three\",1);\n";
+
+      //2 changes, 3 is already so, 10 is new and then updated in the same list
+      theStream1 << "INSERT INTO Notes (id, title, hits) VALUES (2,\"two\",5),(3,\"three\",1),"
+                 << "(10,\"ten\",1),(10,\"TEN\",7) ON DUPLICATE KEY UPDATE title=VALUES(title), hits=VALUES(hits);\n";
+      theStream1 << "INSERT INTO Notes (title, hits) VALUES (\"auto\",1);\n";
+      theStream1 << "INSERT INTO Notes (id, title, hits) VALUES (1,\"uno\",1) ON DUPLICATE KEY UPDATE hits=100;\n";
+      theStream1 << "use " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "select id, title, hits from Notes;\n";
+
+      //in bulk: 5 rows are updated, the other 495 inserted
+      theStream1 << "INSERT INTO Notes (id, title, hits) VALUES ";
+      for(size_t i=1;i<=500;i++) {
+        theStream1 << (i>1 ? "," : "") << "(" << i << ",\"bulk\",2)";
+      }
+      theStream1 << " ON DUPLICATE KEY UPDATE hits=VALUES(hits);\n";
+      theStream1 << "INSERT INTO Notes (title, hits) VALUES (\"last\",1);\n";
+      theStream1 << "select count(*) from Notes where hits=2;\n";
+      theStream1 << "select id, title from Notes where id>499;\n";
+      theStream1 << "drop database " << theDBName2 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      //an update may not change the key
+      std::stringstream theStream2;
+      theStream2 << "use " << theDBName1 << ";\n";
+      theStream2 << "INSERT INTO Notes (id, title) VALUES (1,\"one\") ON DUPLICATE KEY UPDATE id=5;\n";
+      std::stringstream theStream3;
+      theStream3 << "drop database " << theDBName1 << ";\n";
+      theStream3 << "quit;\n";
+      std::stringstream theOutput2;
+      bool theFailed=!doScriptTest(theStream2,theOutput2);
+      doScriptTest(theStream3,theOutput2);
+      output << theOutput2.str();
+
+      std::string theText=theOutput1.str();
+      auto theAffected=[&theText](size_t aCount, size_t aFrom) {
+        return theText.find("Query OK, " + std::to_string(aCount) + " rows affected", aFrom);
+      };
+      size_t thePos=theAffected(2, theText.find("ON DUPLICATE"));
+      thePos=thePos==std::string::npos ? thePos : theAffected(1, theText.find("hits=100"));
+      thePos=thePos==std::string::npos ? thePos : theAffected(500, theText.find("hits=VALUES(hits);"));
+
+      auto theTables=getTables(theText);
+      theResult=theResult && theFailed && thePos!=std::string::npos && theTables.size()==3;
+      if(theResult) {
+        theResult=getColumn(theTables[0], 0)==StringList{"1","2","3","10","11"}
+          && getColumn(theTables[0], 1)==StringList{"one","two","three","TEN","auto"}
+          && getColumn(theTables[0], 2)==StringList{"100","5","1","7","1"}
+          && getColumn(theTables[1], 0)==StringList{"500"}
+          && getColumn(theTables[2], 0)==StringList{"500","501"}
+          && getColumn(theTables[2], 1)==StringList{"bulk","last"};
+      }
+      return theResult;
+    }
+
+    bool doVacuumTest() {
+
+      std::string theDBName1(getRandomDBName('W'));
+      std::string theDBName2(getRandomDBName('W'));
+      std::string theLongBody(2500, 'v');
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "create database " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      addUsersTable(theStream1);
+      insertUsers(theStream1,0,5);
+      theStream1 << "create table Notes (id int NOT NULL auto_increment primary key, "
+                 << "title varchar(20), body varchar(3000));\n";
+      theStream1 << "INSERT INTO Notes (title, body) VALUES ";
+      for(size_t i=0;i<300;i++) {
+        theStream1 << (i ? "," : "") << "(\"note\",\"" << Fake::People::first_name() << "\")";
+      }
+      theStream1 << ";\n";
+      theStream1 << "update Notes set body=\"" << theLongBody << "\" where id=290;\n";
+      theStream1 << "delete from Notes where id<281;\n";
+      theStream1 << "ALTER TABLE Notes add rating int default 5;\n";
+      theStream1 << "dump database " << theDBName1 << ";\n";
+
+      //in steps: 5 rows first, then what is left to move or rewrite
+      theStream1 << "vacuum Notes limit 5;\n";
+      theStream1 << "vacuum;\n";
+      theStream1 << "dump database " << theDBName1 << ";\n";
+
+      //all of it reads back after the database is opened again
+      theStream1 << "use " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "select id, title, rating from Notes where id<285;\n";
+      theStream1 << "select count(*) from Notes where body=\"" << theLongBody << "\";\n";
+      theStream1 << "INSERT INTO Notes (title) VALUES (\"new\");\n";
+      theStream1 << "select count(*) from Notes;\n";
+      theStream1 << "select count(*) from Users;\n";
+      theStream1 << "drop database " << theDBName2 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      std::stringstream theStream2;
+      theStream2 << "use " << theDBName1 << ";\n";
+      theStream2 << "vacuum Missing;\n";
+      std::stringstream theStream3;
+      theStream3 << "drop database " << theDBName1 << ";\n";
+      theStream3 << "quit;\n";
+      std::stringstream theOutput2;
+      bool theFailed=!doScriptTest(theStream2,theOutput2);
+      doScriptTest(theStream3,theOutput2);
+      output << theOutput2.str();
+
+      std::string theText=theOutput1.str();
+      size_t thePos=theText.find("Query OK, 5 rows affected", theText.find("limit 5"));
+      thePos=thePos==std::string::npos ? thePos : theText.find("Query OK, 15 rows affected", thePos);
+
+      auto countOf=[](const StringList& aTypes, const std::string& aType) {
+        return std::count(aTypes.begin(), aTypes.end(), aType);
+      };
+      auto theTables=getTables(theText);
+      theResult=theResult && theFailed && thePos!=std::string::npos && theTables.size()==6;
+      if(theResult) {
+        //5 users and 20 notes, one of them in 3 blocks, in a file that lost
+        //the blocks of the 280 deleted notes
+        auto theBefore=getColumn(theTables[0], 0);
+        auto theAfter=getColumn(theTables[1], 0);
+        theResult=theBefore.size()>300 && theAfter.size()<40
+          && countOf(theAfter, "data")==27 && countOf(theAfter, "free")<5
+          && getColumn(theTables[2], 0)==StringList{"281","282","283","284"}
+          && getColumn(theTables[2], 2)==StringList{"5","5","5","5"}
+          && getColumn(theTables[3], 0)==StringList{"1"}
+          && getColumn(theTables[4], 0)==StringList{"21"}
+          && getColumn(theTables[5], 0)==StringList{"5"};
+      }
+      return theResult && doVacuumChainTest();
+    }
+
+    //rows chained apart from a head with a one digit block number, each
+    //filling 2 blocks exactly; moved to a two digit block, they need 3
+    bool doVacuumChainTest() {
+
+      std::string theDBName1(getRandomDBName('W'));
+      KeyValues theEmpty{{"id", 1}, {"title", std::string("note")}, {"body", std::string()}};
+      std::stringstream theEncoded;
+      Row(theEmpty, 9).encode(theEncoded);
+      size_t theLength=2*kPayloadSize-theEncoded.str().size();
+
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "create table Notes (id int NOT NULL auto_increment primary key, "
+                 << "title varchar(20), body varchar(3000));\n";
+      theStream1 << "INSERT INTO Notes (title, body) VALUES ";
+      for(size_t i=0;i<40;i++) {
+        theStream1 << (i ? "," : "") << "(\"note\",\"x\")";
+      }
+      theStream1 << ";\n";
+      for(char id='1';id<='7';id++) {
+        theStream1 << "update Notes set body=\"" << std::string(theLength, 'a'+id-'1') << "\" where id=" << id << ";\n";
+      }
+      theStream1 << "delete from Notes where id>7;\n";
+      theStream1 << "vacuum Notes;\n";
+      theStream1 << "dump database " << theDBName1 << ";\n";
+      for(char id='1';id<='7';id++) {
+        theStream1 << "select id from Notes where body=\"" << std::string(theLength, 'a'+id-'1') << "\";\n";
+      }
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      std::string theText=theOutput1.str();
+      auto theTables=getTables(theText);
+      theResult=theResult && theTables.size()==8
+        && theText.find("Query OK, 7 rows affected", theText.find("vacuum Notes;"))!=std::string::npos;
+      if(theResult) {
+        //the last row moved first, into 3 blocks
+        auto theIds=getColumn(theTables[0], 1);
+        theResult=std::count(theIds.begin(), theIds.end(), "7")==3;
+        for(size_t i=1;i<8 && theResult;i++) {
+          theResult=getColumn(theTables[i], 0)==StringList{std::to_string(i)};
+        }
+      }
+      return theResult;
+    }
+
     bool doDeleteTest() {
 
       std::string theDBName1(getRandomDBName('F'));
@@ -567,6 +1022,50 @@ namespace ECE141 {
       return theResult;
     }
 
+    bool doMutateTest() {
+
+      std::string theDBName1(getRandomDBName('M'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      addUsersTable(theStream1);
+      addAccountsTable(theStream1);
+      insertFakeUsers(theStream1, 100, 3);
+      theStream1 << "INSERT INTO Accounts (account_type, amount) VALUES ";
+      for(size_t i=0;i<8;i++) {
+        theStream1 << (i ? "," : "") << "(\"checking\"," << 100*i << ")";
+      }
+      theStream1 << ";\n";
+
+      //key lookups and key ranges on Users leave the keys of Accounts alone
+      theStream1 << "delete from Users where id=5;\n";
+      theStream1 << "update Users set zipcode=11111 where id>290;\n";
+      theStream1 << "delete from Users where id>295;\n";
+      theStream1 << "update Users set zipcode=22222 where zipcode=11111;\n";
+      theStream1 << "select id from Users where id>3 limit 3;\n";
+      theStream1 << "select id from Users where zipcode=22222;\n";
+      theStream1 << "select count(*) from Users;\n";
+      theStream1 << "select id from Accounts where id=5;\n";
+      theStream1 << "select id from Accounts where id>5;\n";
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==5;
+      if(theResult) {
+        theResult=getColumn(theTables[0], 0)==StringList{"4","6","7"}
+          && getColumn(theTables[1], 0)==StringList{"291","292","293","294","295"}
+          && getColumn(theTables[2], 0)==StringList{"294"}
+          && getColumn(theTables[3], 0)==StringList{"5"}
+          && getColumn(theTables[4], 0)==StringList{"6","7","8"};
+      }
+      return theResult;
+    }
+
     //test dropping a table...
     bool doDropTest() {
  
@@ -674,10 +1173,751 @@ namespace ECE141 {
           theResult=compareCounts(theCounts,theOpts,8);
         }
       }
+
+      //inner join drops unmatched rows, right join keeps the orphan book
+      std::string theQueries=
+        "select last_name, title from Users join Books on Users.id=Books.user_id order by title;\n"
+        "select title, last_name from Users right join Books on Users.id=Books.user_id order by title;\n"
+        "select title, last_name from Books join Users on Books.user_id=Users.id order by title;\n";
+      std::stringstream theStream2, theOutput2;
+      theStream2 << "create database " << theDBName1 << ";\n";
+      theStream2 << "use " << theDBName1 << ";\n";
+      addUsersTable(theStream2);
+      insertUsers(theStream2,0,6);
+      addBooksTable(theStream2);
+      insertBooks(theStream2,0,14);
+      theStream2 << "INSERT INTO Books (title, user_id) VALUES (\"Orphan\",9);\n";
+      theStream2 << theQueries;
+      theStream2 << "quit;\n";
+
+      //same queries with a tiny budget so they run as sort-merge joins,
+      //plus a primary key to primary key join that merges without sorting
+      std::stringstream theStream3, theOutput3;
+      theStream3 << "use " << theDBName1 << ";\n";
+      theStream3 << theQueries;
+      theStream3 << "select title, last_name from Users join Books on Users.id=Books.id order by title;\n";
+      theStream3 << "drop database " << theDBName1 << ";\n";
+      theStream3 << "quit;\n";
+
+      if(theResult && (theResult=doScriptTest(theStream2,theOutput2))) {
+        size_t theMemory=Config::getSortMemory();
+        Config::setSortMemory(4096);
+        theResult=doScriptTest(theStream3,theOutput3);
+        Config::setSortMemory(theMemory);
+        output << theOutput2.str() << theOutput3.str();
+
+        auto theTables=getTables(theOutput2.str());
+        auto theMerged=getTables(theOutput3.str());
+        theResult=theResult && theTables.size()==3 && theMerged.size()==4;
+        if(theResult) {
+          auto theInner=getColumn(theTables[0], 0);
+          auto theRight=getColumn(theTables[1], 1);
+          auto theIndexed=getColumn(theTables[2], 1);
+          theResult=theInner.size()==14 && theRight.size()==15 && theIndexed.size()==14
+            && std::count(theRight.begin(), theRight.end(), "NULL")==1
+            && std::count(theInner.begin(), theInner.end(), "king")==5
+            && std::count(theIndexed.begin(), theIndexed.end(), "king")==5;
+          for(size_t i=0;theResult && i<theTables.size();i++) {
+            theResult=getColumn(theTables[i], 0)==getColumn(theMerged[i], 0)
+              && getColumn(theTables[i], 1)==getColumn(theMerged[i], 1);
+          }
+          //books 1-6 pair with the 6 users by id
+          theResult=theResult && getColumn(theMerged[3], 0).size()==6;
+        }
+      }
       return theResult;
       
     }
 
+    //split the output after each printed table, one entry per table
+    std::vector<std::string> getTables(const std::string &anOutput) {
+      std::vector<std::string> theTables;
+      for(size_t thePos=anOutput.find("rows in set");thePos!=std::string::npos;
+          thePos=anOutput.find("rows in set",thePos+1)) {
+        theTables.push_back(anOutput.substr(0,thePos+11));
+      }
+      return theTables;
+    }
+
+    //collect one column from the rows of the last table in the output
+    std::vector<std::string> getColumn(const std::string &anOutput, size_t aColumn) {
+      std::vector<std::string> theValues;
+      std::stringstream theStream(anOutput);
+      std::string theLine;
+      bool isHeader=true;
+      while(std::getline(theStream, theLine)) {
+        if(theLine.size()<2 || theLine[0]!='|') {
+          if(theLine.find("rows in set")==std::string::npos) continue;
+          isHeader=true;
+          continue;
+        }
+        if(isHeader) { //first bar line is the field names
+          isHeader=false;
+          theValues.clear();
+          continue;
+        }
+        std::stringstream theRow(theLine);
+        std::string theCell;
+        for(size_t i=0;i<=aColumn+1;i++) std::getline(theRow, theCell, '|');
+        theCell.erase(theCell.find_last_not_of(' ')+1);
+        theCell.erase(0, theCell.find_first_not_of(' '));
+        theValues.push_back(theCell);
+      }
+      return theValues;
+    }
+
+    bool doProjectionTest() {
+
+      std::string theDBName1(getRandomDBName('P'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+
+      addUsersTable(theStream1);
+      insertUsers(theStream1,0,6);
+
+      //the filters read columns the select leaves out
+      theStream1 << "select first_name from Users where zipcode=92120;\n";
+      theStream1 << "select last_name, id from Users where first_name=\"pu\";\n";
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==2;
+      if(theResult) {
+        //the field names of the last table in the output
+        auto theHeader=[](const std::string& aTable) {
+          size_t thePrev=aTable.rfind("rows in set", aTable.size()-12);
+          std::string theLine=aTable.substr(aTable.find('|', thePrev==std::string::npos ? 0 : thePrev));
+          theLine=theLine.substr(0, theLine.find('\n'));
+          theLine.erase(std::remove(theLine.begin(), theLine.end(), ' '), theLine.end());
+          return theLine;
+        };
+        theResult=theHeader(theTables[0])=="|first_name|"
+          && getColumn(theTables[0], 0)==StringList{"jody","ted"}
+          && theHeader(theTables[1])=="|id|last_name|"
+          && getColumn(theTables[1], 0)==StringList{"6"}
+          && getColumn(theTables[1], 1)==StringList{"cheng"};
+      }
+      return theResult;
+    }
+
+    bool doLimitTest() {
+
+      std::string theDBName1(getRandomDBName('K'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+
+      addUsersTable(theStream1);
+      insertUsers(theStream1,0,6);
+      insertFakeUsers(theStream1,50,2);
+
+      //in scan order
+      theStream1 << "select id from Users limit 2;\n";
+      theStream1 << "select id from Users limit 2 offset 3;\n";
+      theStream1 << "select id from Users limit 3, 2;\n";
+      theStream1 << "select id from Users limit 5 offset 104;\n";
+      theStream1 << "select id from Users limit 5 offset 200;\n";
+
+      //ordered, the limited ones keep only the top rows while sorting
+      theStream1 << "select id, zipcode from Users order by zipcode, id;\n";
+      theStream1 << "select id, zipcode from Users order by zipcode, id limit 10 offset 20;\n";
+      theStream1 << "select id, zipcode from Users order by zipcode desc, id desc limit 3, 4;\n";
+      theStream1 << "select id, zipcode from Users order by zipcode, id limit 5 offset 500;\n";
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==9;
+      if(theResult) {
+        auto theAll=getColumn(theTables[5], 0);
+        StringList theSlice(theAll.begin()+20, theAll.begin()+30);
+        StringList theTop(theAll.rbegin()+3, theAll.rbegin()+7);
+        theResult=getColumn(theTables[0], 0)==StringList{"1","2"}
+          && getColumn(theTables[1], 0)==StringList{"4","5"}
+          && getColumn(theTables[2], 0)==StringList{"4","5"}
+          && getColumn(theTables[3], 0)==StringList{"105","106"}
+          && getColumn(theTables[4], 0).empty()
+          && theAll.size()==106
+          && getColumn(theTables[6], 0)==theSlice
+          && getColumn(theTables[7], 0)==theTop
+          && getColumn(theTables[8], 0).empty();
+      }
+      return theResult;
+    }
+
+    bool doOrderByTest() {
+
+      std::string theDBName1(getRandomDBName('K'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+
+      addUsersTable(theStream1);
+      insertFakeUsers(theStream1,50,2);
+      theStream1 << "INSERT INTO Users (first_name, last_name, zipcode) VALUES (\"a\",\"b\",9), (\"c\",\"d\",10);\n";
+      theStream1 << "select last_name, zipcode from Users order by zipcode desc, last_name;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+      if(theResult) {
+        auto theZips=getColumn(theOutput1.str(), 1);
+        auto theNames=getColumn(theOutput1.str(), 0);
+        theResult=theZips.size()==102 && theZips[100]=="10" && theZips[101]=="9";
+        for(size_t i=1;theResult && i<theZips.size();i++) {
+          int thePrev=std::stoi(theZips[i-1]), theNext=std::stoi(theZips[i]);
+          theResult=thePrev>theNext || (thePrev==theNext && theNames[i-1]<=theNames[i]);
+        }
+
+        //same query with a tiny sort budget so the sort spills to disk
+        std::stringstream theStream3, theOutput3;
+        theStream3 << "use " << theDBName1 << ";\n";
+        theStream3 << "select last_name, zipcode from Users order by zipcode desc, last_name;\n";
+        size_t theMemory=Config::getSortMemory();
+        Config::setSortMemory(4096);
+        theResult=doScriptTest(theStream3,theOutput3) && theResult;
+        Config::setSortMemory(theMemory);
+        output << theOutput3.str();
+        theResult=theResult && getColumn(theOutput3.str(), 0)==theNames
+          && getColumn(theOutput3.str(), 1)==theZips;
+      }
+
+      std::stringstream theStream2;
+      theStream2 << "drop database " << theDBName1 << ";\n";
+      theStream2 << "quit;\n";
+      return doScriptTest(theStream2,output) && theResult;
+    }
+
+    bool doAggregateTest() {
+
+      std::string theDBName1(getRandomDBName('G'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+
+      addUsersTable(theStream1);
+      insertUsers(theStream1,0,6);
+      theStream1 << "select count(*), min(zipcode), max(zipcode), sum(zipcode) from Users;\n";
+      theStream1 << "select zipcode, count(*) as total from Users group by zipcode order by zipcode;\n";
+      insertFakeUsers(theStream1,50,3);
+      theStream1 << "select zipcode, count(*), max(last_name) from Users group by zipcode order by zipcode;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==3;
+      if(theResult) {
+        theResult=getColumn(theTables[0], 0)==StringList{"6"} && getColumn(theTables[0], 1)==StringList{"85023"}
+          && getColumn(theTables[0], 2)==StringList{"92125"} && getColumn(theTables[0], 3)==StringList{"545635"}
+          && getColumn(theTables[1], 0).size()==5 && getColumn(theTables[1], 1)[1]=="2";
+      }
+
+      //group without by is an error, not a plain select
+      std::stringstream theStream3, theOutput3;
+      theStream3 << "use " << theDBName1 << ";\n";
+      theStream3 << "select zipcode, count(*) from Users group zipcode;\n";
+      theResult=theResult && !doScriptTest(theStream3,theOutput3)
+        && getTables(theOutput3.str()).empty();
+      output << theOutput3.str();
+
+      //the same grouping with a tiny budget spills groups to disk
+      std::stringstream theStream2, theOutput2;
+      theStream2 << "use " << theDBName1 << ";\n";
+      theStream2 << "select zipcode, count(*), max(last_name) from Users group by zipcode order by zipcode;\n";
+      //row count and key range come from metadata, check them against scans
+      theStream2 << "delete from Users where zipcode=92120;\n";
+      theStream2 << "select count(*), min(id), max(id) from Users;\n";
+      theStream2 << "select count(zipcode) from Users;\n";
+      theStream2 << "select id from Users order by id desc limit 1;\n";
+      theStream2 << "drop database " << theDBName1 << ";\n";
+      theStream2 << "quit;\n";
+      size_t theMemory=Config::getSortMemory();
+      Config::setSortMemory(1024);
+      bool theSpilled=doScriptTest(theStream2,theOutput2);
+      Config::setSortMemory(theMemory);
+      output << theOutput2.str();
+
+      if(theResult) {
+        size_t theRows=0;
+        for(auto &theCount : getColumn(theTables[2], 1)) theRows+=std::stoi(theCount);
+        auto theSpills=getTables(theOutput2.str());
+        theResult=theSpilled && theRows==156 && theSpills.size()==4;
+        for(size_t i=0;theResult && i<3;i++) {
+          theResult=getColumn(theTables[2], i)==getColumn(theSpills[0], i);
+        }
+        theResult=theResult && getColumn(theSpills[1], 0)==getColumn(theSpills[2], 0)
+          && getColumn(theSpills[1], 0)[0]!="156" && getColumn(theSpills[1], 1)[0]=="1"
+          && getColumn(theSpills[1], 2)==getColumn(theSpills[3], 0);
+      }
+      return theResult;
+    }
+
+    bool doDistinctTest() {
+
+      std::string theDBName1(getRandomDBName('T'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+
+      addUsersTable(theStream1);
+      insertUsers(theStream1,0,6);
+      insertFakeUsers(theStream1,50,3);
+      theStream1 << "select zipcode from Users order by zipcode;\n";
+      theStream1 << "select distinct zipcode from Users;\n";
+      theStream1 << "select distinct zipcode from Users order by zipcode;\n";
+      theStream1 << "select distinct id, zipcode from Users;\n";
+      theStream1 << "quit;\n";
+
+      //sorted distinct again with a budget small enough to spill
+      std::stringstream theStream2;
+      theStream2 << "use " << theDBName1 << ";\n";
+      theStream2 << "select distinct zipcode from Users order by zipcode;\n";
+      theStream2 << "drop database " << theDBName1 << ";\n";
+      theStream2 << "quit;\n";
+
+      std::stringstream theOutput1, theOutput2;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      size_t theMemory=Config::getSortMemory();
+      Config::setSortMemory(4096);
+      theResult=doScriptTest(theStream2,theOutput2) && theResult;
+      Config::setSortMemory(theMemory);
+      output << theOutput1.str() << theOutput2.str();
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==4;
+      if(theResult) {
+        auto theExpected=getColumn(theTables[0], 0);
+        theExpected.erase(std::unique(theExpected.begin(), theExpected.end()), theExpected.end());
+
+        auto theHashed=getColumn(theTables[1], 0);
+        std::sort(theHashed.begin(), theHashed.end());
+        std::sort(theExpected.begin(), theExpected.end());
+        theResult=theHashed==theExpected && getColumn(theTables[3], 0).size()==156;
+
+        auto theSorted=getColumn(theTables[2], 0);
+        std::sort(theSorted.begin(), theSorted.end());
+        theResult=theResult && theSorted==theExpected
+          && getColumn(theTables[2], 0)==getColumn(theOutput2.str(), 0);
+      }
+      return theResult;
+    }
+
+    bool doScanTest() {
+
+      std::string theDBName1(getRandomDBName('T'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+
+      addUsersTable(theStream1);
+      insertUsers(theStream1,0,6);
+      insertFakeUsers(theStream1,50,4);
+      theStream1 << "quit;\n";
+
+      //the same queries on one thread, then split across four
+      std::stringstream theQueries;
+      theQueries << "use " << theDBName1 << ";\n";
+      theQueries << "select id, zipcode from Users where zipcode>50000;\n";
+      theQueries << "select id, last_name from Users where zipcode<70000 order by id desc;\n";
+      theQueries << "select id, zipcode from Users where zipcode>20000 limit 5 offset 100;\n";
+      theQueries << "select last_name, zipcode from Users order by zipcode limit 7;\n";
+      std::stringstream theStream2(theQueries.str()+"quit;\n");
+      std::stringstream theStream3(theQueries.str()+"drop database "+theDBName1+";\nquit;\n");
+
+      std::stringstream theOutput1, theOutput2, theOutput3;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      size_t theThreads=Config::getParallelism();
+      Config::setParallelism(1);
+      theResult=doScriptTest(theStream2,theOutput2) && theResult;
+      Config::setParallelism(4);
+      theResult=doScriptTest(theStream3,theOutput3) && theResult;
+      Config::setParallelism(theThreads);
+      output << theOutput1.str() << theOutput2.str() << theOutput3.str();
+
+      auto theSerial=getTables(theOutput2.str());
+      auto theParallel=getTables(theOutput3.str());
+      theResult=theResult && theSerial.size()==4 && theParallel.size()==4;
+      for(size_t i=0;theResult && i<4;i++) {
+        theResult=getColumn(theSerial[i], 0)==getColumn(theParallel[i], 0)
+          && getColumn(theSerial[i], 1)==getColumn(theParallel[i], 1);
+      }
+      //tasks of a cancelled group are skipped, the others all run
+      {
+        Scheduler theScheduler(2);
+        std::atomic<size_t> theRuns{0};
+        TaskGroup theGroup(theScheduler), theCancelled(theScheduler);
+        theCancelled.cancel();
+        for(size_t i=0;i<100;i++) {
+          theGroup.run([&theRuns]{ ++theRuns; });
+          theCancelled.run([&theRuns]{ theRuns+=1000; });
+        }
+        theGroup.wait();
+        theCancelled.wait();
+        theResult=theResult && theRuns==100;
+      }
+      if(theResult) {
+        auto theIds=getColumn(theParallel[1], 0);
+        theResult=getColumn(theParallel[2], 0).size()==5 && theIds.size()>1
+          && std::stoi(theIds[0])>std::stoi(theIds[1]);
+      }
+      return theResult;
+    }
+
+    bool doExplainTest() {
+
+      std::string theDBName1(getRandomDBName('T'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+
+      addUsersTable(theStream1);
+      addBooksTable(theStream1);
+      insertUsers(theStream1,0,6);
+      insertBooks(theStream1,0,14);
+      theStream1 << "explain select * from Users where zipcode>92120 order by last_name limit 2;\n";
+      theStream1 << "explain analyze select * from Users where zipcode>92120 order by last_name limit 2;\n";
+      theStream1 << "explain analyze select title, last_name from Books left join Users on Books.user_id=Users.id order by title;\n";
+      theStream1 << "explain analyze select zipcode, count(*) from Users group by zipcode;\n";
+      theStream1 << "explain select count(*) from Users;\n";
+      theStream1 << "explain analyze select * from Users where id>4;\n";
+      theStream1 << "explain select title, last_name from Books join Users on Books.user_id=Users.id where id<3;\n";
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==7;
+      if(theResult) {
+        //plain explain lists the operators without running them
+        auto theOperations=getColumn(theTables[0], 1);
+        theResult=theOperations==StringList{"select", "limit", "top-k", "scan"}
+          && theTables[0].find("time (ms)")==std::string::npos;
+
+        //analyze counts what each operator produced and read
+        auto theRows=getColumn(theTables[1], 3);
+        auto theBlocks=getColumn(theTables[1], 5);
+        theResult=theResult && getColumn(theTables[1], 1)==theOperations
+          && theRows==StringList{"2", "2", "2", "3"} && theBlocks.size()==4 && theBlocks[3]=="6";
+
+        //hashing six users beats probing for the key of every book
+        auto theJoin=getColumn(theTables[2], 1);
+        theResult=theResult && theJoin.size()==5 && theJoin[2]=="hash join"
+          && getColumn(theTables[2], 3)[0]=="14";
+
+        theResult=theResult && getColumn(theTables[3], 1)==StringList{"select", "hash aggregate", "scan"}
+          && getColumn(theTables[3], 3)==StringList{"5", "5", "6"}
+          && getColumn(theTables[4], 1)==StringList{"select", "aggregate"};
+
+        //a key range only reads its own blocks
+        theResult=theResult && getColumn(theTables[5], 1)==StringList{"select", "range scan"}
+          && getColumn(theTables[5], 3)==StringList{"2", "2"} && getColumn(theTables[5], 5)[1]=="2";
+
+        //a couple of books probe the users index instead
+        theResult=theResult && getColumn(theTables[6], 1)==StringList{"select",
+          "index nested loop join", "range scan", "index lookup"};
+      }
+      return theResult;
+    }
+
+    bool doStatsTest() {
+
+      std::string theDBName1(getRandomDBName('W'));
+      std::string theDBName2(getRandomDBName('W'));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "create database " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+
+      addUsersTable(theStream1);
+      insertUsers(theStream1,0,6);
+      theStream1 << "show stats Users;\n";
+      theStream1 << "analyze table Users;\n";
+      theStream1 << "use " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "show stats Users;\n";
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "drop database " << theDBName2 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==2;
+      if(theResult) {
+        //before analyze only the primary key is known
+        theResult=getColumn(theTables[0], 0)==StringList{"id"}
+          && getColumn(theTables[0], 2)==StringList{"6"};
+
+        //the stored statistics survive closing the database
+        auto theColumns=getColumn(theTables[1], 0);
+        auto theDistinct=getColumn(theTables[1], 2);
+        auto theMin=getColumn(theTables[1], 3);
+        auto theMax=getColumn(theTables[1], 4);
+        theResult=theResult && theColumns==StringList{"first_name", "id", "last_name", "zipcode"}
+          && theDistinct==StringList{"6", "6", "6", "5"}
+          && theMin[3]=="85023" && theMax[3]=="92125"
+          && getColumn(theTables[1], 5)[3].find("85023, ")==0;
+      }
+      return theResult;
+    }
+
+    bool doBulkInsertTest() {
+
+      std::string theDBName1(getRandomDBName('K'));
+      std::string theDBName2(getRandomDBName('K'));
+      std::string theLongBody(1500, 'x');
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "create database " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+
+      //more rows than one write batch, then a second insert that reuses the
+      //freed blocks and holds a row longer than a block
+      theStream1 << "create table Notes (id int NOT NULL auto_increment primary key, "
+                 << "title varchar(20), body varchar(2000));\n";
+      for(size_t theInsert=0;theInsert<2;theInsert++) {
+        theStream1 << "INSERT INTO Notes (title, body) VALUES ";
+        for(size_t i=0;i<(theInsert ? 20 : 300);i++) {
+          theStream1 << (i ? "," : "") << "(\"" << Fake::People::last_name() << "\",\""
+                     << (theInsert && !i ? theLongBody : Fake::People::first_name()) << "\")";
+        }
+        theStream1 << ";\n";
+        if(!theInsert) {
+          theStream1 << "delete from Notes where id<11;\n";
+        }
+      }
+      theStream1 << "use " << theDBName2 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      theStream1 << "select count(*) from Notes;\n";
+      theStream1 << "select id, title from Notes where id>300;\n";
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "drop database " << theDBName2 << ";\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      output << theOutput1.str();
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==2;
+      if(theResult) {
+        //the blocks chained for the long row (301) took none of the blocks
+        //of the rows after it or of the index
+        auto theIds=getColumn(theTables[1], 0);
+        theResult=getColumn(theTables[0], 0)==StringList{"310"} && theIds.size()==20;
+        for(size_t i=0;theResult && i<theIds.size();i++) {
+          theResult=theIds[i]==std::to_string(301+i);
+        }
+      }
+      return theResult;
+    }
+
+    bool doLoadTest() {
+
+      std::string theDBName1(getRandomDBName('L'));
+      std::string theCSVPath(Config::getTempPath("load"));
+      std::string theJSONPath(Config::getTempPath("load"));
+      std::string theBadPath(Config::getTempPath("load"));
+
+      //every 10th row has no zipcode, every 50th a quoted name with a
+      //comma, an escaped quote and a line break
+      {
+        std::ofstream theCSV(theCSVPath), theJSON(theJSONPath), theBad(theBadPath);
+        theCSV << "zipcode,last_name,first_name\n";
+        for(size_t i=0;i<200;i++) {
+          theCSV << (i%10 ? std::to_string(10000+i) : "") << ',';
+          if(i%50) theCSV << Fake::People::last_name();
+          else theCSV << "\"O\"\"Neil, \nJr.\"";
+          theCSV << ',' << Fake::People::first_name() << "\n";
+        }
+        for(size_t i=0;i<50;i++) {
+          theJSON << "{\"first_name\": \"" << Fake::People::first_name() << "\", \"last_name\": \"Caf\\u00e9\", "
+                  << "\"zipcode\": " << (i%10 ? std::to_string(20000+i) : "null") << "}\n";
+        }
+        //100 good records spread over several chunks, a bad one, 100 more
+        theBad << "first_name,zipcode\n";
+        for(size_t i=0;i<200;i++) {
+          theBad << (i==100 ? "Bob,nine\n" : "Anna,"+std::to_string(92000+i)+"\n");
+        }
+      }
+
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      addUsersTable(theStream1);
+      theStream1 << "load data from '" << theCSVPath << "' into table Users;\n";
+      theStream1 << "load data from '" << theJSONPath << "' into table Users format json;\n";
+      theStream1 << "select count(*), count(zipcode) from Users;\n";
+      theStream1 << "select last_name from Users where id=51;\n";
+      theStream1 << "select last_name from Users where id=250;\n";
+      theStream1 << "quit;\n";
+
+      std::stringstream theStream2;
+      theStream2 << "use " << theDBName1 << ";\n";
+      theStream2 << "load data from '" << theBadPath << "' into table Users;\n";
+      std::stringstream theStream3("use "+theDBName1+";\nselect count(*) from Users;\n"
+        +"drop database "+theDBName1+";\nquit;\n");
+
+      //small chunks, so that the files are parsed in many parallel pieces
+      size_t theChunkSize=Config::getLoadChunkSize();
+      Config::setLoadChunkSize(512);
+      std::stringstream theOutput1, theOutput2, theOutput3;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      bool theFailed=!doScriptTest(theStream2,theOutput2);
+      theResult=doScriptTest(theStream3,theOutput3) && theResult && theFailed;
+      Config::setLoadChunkSize(theChunkSize);
+      output << theOutput1.str() << theOutput2.str() << theOutput3.str();
+      std::remove(theCSVPath.c_str());
+      std::remove(theJSONPath.c_str());
+      std::remove(theBadPath.c_str());
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==3
+        && theOutput2.str().find("bad record on line 102")!=std::string::npos;
+      if(theResult) {
+        //the bad file loads the 100 records before its bad line and none after
+        theResult=getColumn(theTables[0], 0)==StringList{"250"}
+          && getColumn(theTables[0], 1)==StringList{"225"}
+          && theTables[1].find("O\"Neil, \nJr.")!=std::string::npos
+          && getColumn(theTables[2], 0)==StringList{"Caf\u00e9"}
+          && getColumn(getTables(theOutput3.str()).back(), 0)==StringList{"350"};
+      }
+
+      //text stored before escaping keeps its backslashes; escaped text is
+      //stored under its own type letter and reads back whole
+      if(theResult) {
+        std::string theText("a\"b\\c");
+        std::stringstream theOld("5 last_name s \"C:\\temp\\\" "), theNew;
+        Row theOldRow, theNewRow;
+        theOldRow.decode(theOld);
+        Row(KeyValues{{"last_name", theText}}, 7).encode(theNew);
+        theNewRow.decode(theNew);
+        theResult=theOldRow.getValue("last_name")==Value(std::string("C:\\temp\\"))
+          && theNew.str().find(" e ")!=std::string::npos
+          && theNewRow.getValue("last_name")==Value(theText);
+      }
+      return theResult;
+    }
+
+    //rows of each group in a COPY ... FORMAT BINARY file, empty if it is not one
+    std::vector<uint32_t> readColumnarGroups(const std::string &aPath, StringList &aColumns) {
+      std::vector<uint32_t> theGroups;
+      std::ifstream theFile(aPath, std::ios::binary);
+      char theMagic[8];
+      uint32_t theCount=0, theSize=0;
+      if(!theFile.read(theMagic,8) || std::string(theMagic,8)!="ECE141C1") return theGroups;
+      theFile.read((char*)&theCount,4);
+      for(uint32_t i=0;i<theCount && theFile.read((char*)&theSize,4);i++) {
+        std::string theName(theSize,' ');
+        theFile.read(&theName[0],theSize);
+        aColumns.push_back(theName);
+      }
+      uint32_t theRows=0;
+      while(theFile.read((char*)&theRows,4) && theRows) {
+        theGroups.push_back(theRows);
+        for(uint32_t i=0;i<theCount;i++) {
+          char theType=theFile.get();
+          std::string theBitmap((theRows+7)/8,' ');
+          theFile.read(&theBitmap[0],theBitmap.size());
+          for(uint32_t r=0;r<theRows;r++) {
+            if(!(theBitmap[r/8] & (1<<(r%8)))) continue;
+            switch(theType) {
+              case 'b': theFile.seekg(1,std::ios::cur); break;
+              case 'i': theFile.seekg(4,std::ios::cur); break;
+              case 'd': theFile.seekg(8,std::ios::cur); break;
+              default:  theFile.read((char*)&theSize,4); theFile.seekg(theSize,std::ios::cur);
+            }
+          }
+        }
+      }
+      return theFile ? theGroups : std::vector<uint32_t>();
+    }
+
+    bool doCopyTest() {
+
+      std::string theDBName1(getRandomDBName('C'));
+      std::string theCSVPath(Config::getTempPath("copy"));
+      std::string theBinaryPath(Config::getTempPath("copy"));
+      std::string theJoinPath(Config::getTempPath("copy"));
+      std::stringstream theStream1;
+      theStream1 << "create database " << theDBName1 << ";\n";
+      theStream1 << "use " << theDBName1 << ";\n";
+      addUsersTable(theStream1);
+      insertFakeUsers(theStream1, 100, 50);
+
+      //a CSV export loads back into a table of the same shape
+      theStream1 << "copy (select * from Users) to '" << theCSVPath << "';\n";
+      theStream1 << "create table Copies (id int NOT NULL auto_increment primary key, "
+                 << "first_name varchar(50) NOT NULL, last_name varchar(50), zipcode int);\n";
+      theStream1 << "load data from '" << theCSVPath << "' into table Copies;\n";
+      theStream1 << "select id, last_name, zipcode from Users where id<40;\n";
+      theStream1 << "select id, last_name, zipcode from Copies where id<40;\n";
+      theStream1 << "copy (select id, zipcode, last_name from Users order by zipcode) to '"
+                 << theBinaryPath << "' format binary;\n";
+      theStream1 << "select count(*) from Copies;\n";
+
+      //select * over a join exports the columns of both tables
+      addBooksTable(theStream1);
+      insertBooks(theStream1,0,14);
+      theStream1 << "copy (select * from Users join Books on Users.id=Books.user_id) to '"
+                 << theJoinPath << "';\n";
+      theStream1 << "drop database " << theDBName1 << ";\n";
+      theStream1 << "quit;\n";
+
+      //a small buffer, so that the exports write many times
+      size_t theBufferSize=Config::getExportBufferSize();
+      Config::setExportBufferSize(4096);
+      std::stringstream theOutput1;
+      bool theResult=doScriptTest(theStream1,theOutput1);
+      Config::setExportBufferSize(theBufferSize);
+      output << theOutput1.str();
+
+      StringList theColumns;
+      auto theGroups=readColumnarGroups(theBinaryPath, theColumns);
+      StringList theJoined;
+      std::ifstream theJoinFile(theJoinPath);
+      for(std::string theLine; std::getline(theJoinFile, theLine);) {
+        theJoined.push_back(theLine);
+      }
+      theJoinFile.close();
+      std::remove(theCSVPath.c_str());
+      std::remove(theBinaryPath.c_str());
+      std::remove(theJoinPath.c_str());
+
+      auto theTables=getTables(theOutput1.str());
+      theResult=theResult && theTables.size()==3 && theGroups.size()==2
+        && theColumns==StringList{"id","zipcode","last_name"}
+        && theJoined.size()==15
+        && theJoined[0]=="id,first_name,last_name,zipcode,title,subtitle,user_id"
+        && std::count_if(theJoined.begin(), theJoined.end(), [](const std::string& aLine) {
+             return aLine.find(",Thud,,1")!=std::string::npos; })==1;
+      if(theResult) {
+        theResult=getColumn(theTables[0], 0).size()==39
+          && getColumn(theTables[0], 0)==getColumn(theTables[1], 0)
+          && getColumn(theTables[0], 1)==getColumn(theTables[1], 1)
+          && getColumn(theTables[0], 2)==getColumn(theTables[1], 2)
+          && getColumn(theTables[2], 0)==StringList{"5000"}
+          && theGroups[0]==ColumnarWriter::kGroupRows && theGroups[1]==5000-theGroups[0];
+      }
+      return theResult;
+    }
+
     bool doCacheTest() {
       bool theResult=false;
       return theResult;
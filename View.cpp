@@ -10,12 +10,12 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <map>
+#include <sstream>
+#include <algorithm>
 #include "View.hpp"
 
 namespace ECE141 {
 
-    using OrderedRow = std::map<std::string, RowCollection>;
-
     bool View::show(ShowResult aShow) {
         aShow(output);
         return true;
@@ -210,44 +210,24 @@ namespace ECE141 {
         anOutput << "|\n";
     }
 
-    static void reorderRow(std::shared_ptr<Query>& aQuery, RowCollection& aCollection, 
-        OrderedRow& anOrderedRow) {
-        size_t maxSize = 0;
-
-        std::string orderBy = "id";
-        auto ascend = aQuery->getAscend();
-        if (aQuery->getOrderBy().size()) {
-            orderBy = aQuery->getOrderBy()[0];
-        }        
-
-        for (auto& row : aCollection) {
-            std::stringstream ss;
-            ss << row->getValue(orderBy);
-            std::string key = ss.str();
-            anOrderedRow[key].push_back(std::move(row));
-        }
-    }
-    
-    static std::unordered_map<std::string, size_t> getAttributeMaxSize(OrderedRow& aRows, const size_t kRowWidth) {
+    static std::unordered_map<std::string, size_t> getAttributeMaxSize(RowCollection& aRows, const size_t kRowWidth) {
         std::unordered_map<std::string, size_t> res;
 
-        for (auto& field : aRows) {
-            for (auto& row : field.second) {
-                for (auto& cur : row->getData()) {
-                    std::string* str = std::get_if<std::string>(&cur.second);
-                    res[cur.first] = std::max(res[cur.first], cur.first.size() + 1);
-                    if (str)
-                        res[cur.first] = std::max(res[cur.first], str->size() + 1);
-                    else
-                        res[cur.first] = std::max(kRowWidth, res[cur.first]);
-                }
+        for (auto& row : aRows) {
+            for (auto& cur : row->getData()) {
+                std::string* str = std::get_if<std::string>(&cur.second);
+                res[cur.first] = std::max(res[cur.first], cur.first.size() + 1);
+                if (str)
+                    res[cur.first] = std::max(res[cur.first], str->size() + 1);
+                else
+                    res[cur.first] = std::max(kRowWidth, res[cur.first]);
             }
         }
 
         return res;
     }
 
-    static void showData(std::ostream& anOutput, std::shared_ptr<Query>& aQuery, OrderedRow& aRows,
+    static void showData(std::ostream& anOutput, std::shared_ptr<Query>& aQuery, RowCollection& aRows,
         std::unordered_map<std::string, size_t>& aMaxSize, 
         const size_t kRowWidth) {
         /* data row, will look like
@@ -268,38 +248,38 @@ namespace ECE141 {
                 selects.push_back(att.getName());
         }
 
-        //output data
-        for (auto& field : aRows) {
-            for (auto& row : field.second) {
-                KeyValues data = row->getData();
+        //output data, rows arrive already ordered by the engine
+        for (auto& row : aRows) {
+            KeyValues data = row->getData();
 
-                //id field is the first column by default
-                if (selectAll || std::find(selects.begin(), selects.end(), "id") != selects.end())
-                    anOutput << "| " << std::setw(aMaxSize["id"]) << std::left << data["id"];
+            //id field is the first column by default
+            if (selectAll || std::find(selects.begin(), selects.end(), "id") != selects.end())
+                anOutput << "| " << std::setw(aMaxSize["id"]) << std::left << data["id"];
 
-                for (auto& cur : selects) {
-                    //id field is already taken care
-                    if (cur == "id") {
-                        continue;
-                    }
+            for (auto& cur : selects) {
+                //id field is already taken care
+                if (cur == "id") {
+                    continue;
+                }
 
-                    if (selectAll || std::find(selects.begin(), selects.end(), cur) != selects.end()) {
-                        anOutput << "| " << std::setw(aMaxSize[cur]) << std::left;
-                        if (data[cur].index() == 0) { //is a bool
-                            auto val = std::get_if<bool>(&data[cur]);
-
-                            if (*val == true)
-                                anOutput << "true";
-                            else
-                                anOutput << "false";
-                        }
-                        else { //is int, double or string
-                            anOutput << data[cur];
-                        }
+                if (selectAll || std::find(selects.begin(), selects.end(), cur) != selects.end()) {
+                    anOutput << "| " << std::setw(aMaxSize[cur]) << std::left;
+                    if (!data.count(cur)) //no value, e.g. a column added later
+                        anOutput << "NULL";
+                    else if (data[cur].index() == 0) { //is a bool
+                        auto val = std::get_if<bool>(&data[cur]);
+
+                        if (*val == true)
+                            anOutput << "true";
+                        else
+                            anOutput << "false";
+                    }
+                    else { //is int, double or string
+                        anOutput << data[cur];
                     }
                 }
-                anOutput << "|\n";
             }
+            anOutput << "|\n";
         }
     }
 
@@ -309,16 +289,17 @@ namespace ECE141 {
         if (!aQuery)
             return false;
 
-        //reorder data        
-        OrderedRow orderedRow;
-        reorderRow(aQuery, aCollection, orderedRow);
-
-        auto maxSize = getAttributeMaxSize(orderedRow, kRowWidth);
+        auto maxSize = getAttributeMaxSize(aCollection, kRowWidth);
+        //a column without any value still fits its name and NULL
+        for (auto& att : aQuery->getFrom() ? aQuery->getFrom()->getAttributes() : AttributeList()) {
+            if (!maxSize.count(att.getName()))
+                maxSize[att.getName()] = std::max(att.getName().size() + 1, size_t(5));
+        }
 
         setSeperationBar(output, maxSize, aQuery, kRowWidth);                
         setFieldBar(output, maxSize, aQuery, kRowWidth);        
         setSeperationBar(output, maxSize, aQuery, kRowWidth);
-        showData(output, aQuery, orderedRow, maxSize, kRowWidth);
+        showData(output, aQuery, aCollection, maxSize, kRowWidth);
         setSeperationBar(output, maxSize, aQuery, kRowWidth);
 
         output << aCollection.size() << " rows in set ";
@@ -347,6 +328,96 @@ namespace ECE141 {
         output << anIndexes.size() << " rows in set ";
     }
 
+    bool PlanView::showPlan(const QueryPlan& aPlan) {
+        bool analyze = aPlan.isAnalyze();
+        auto& theSteps = aPlan.getSteps();
+
+        //nested operators are indented under the one that started them
+        std::vector<std::string> theOperations;
+        size_t theOpWidth = 10, theDetailWidth = 7;
+        for (auto& step : theSteps) {
+            theOperations.push_back(std::string(2 * step.depth, ' ') + step.operation);
+            theOpWidth = std::max(theOpWidth, theOperations.back().size() + 1);
+            theDetailWidth = std::max(theDetailWidth, step.detail.size() + 1);
+        }
+
+        std::string theBar = "+----+" + std::string(theOpWidth + 1, '-') + "+" + std::string(theDetailWidth + 1, '-') + "+";
+        if (analyze)
+            theBar += "---------+-----------+---------+";
+        theBar += "\n";
+
+        output << theBar << "| id | " << std::setw(theOpWidth) << std::left << "operation"
+            << "| " << std::setw(theDetailWidth) << std::left << "detail" << "|";
+        if (analyze)
+            output << " rows    | time (ms) | blocks  |";
+        output << "\n" << theBar;
+
+        for (size_t i = 0; i < theSteps.size(); ++i) {
+            output << "| " << std::setw(3) << std::left << i + 1
+                << "| " << std::setw(theOpWidth) << std::left << theOperations[i]
+                << "| " << std::setw(theDetailWidth) << std::left << theSteps[i].detail << "|";
+            if (analyze) {
+                std::ostringstream theTime;
+                theTime << std::fixed << std::setprecision(3) << theSteps[i].elapsed * 1000;
+                output << " " << std::setw(8) << std::left << theSteps[i].rows
+                    << "| " << std::setw(10) << std::left << theTime.str()
+                    << "| " << std::setw(8) << std::left << theSteps[i].blocks << "|";
+            }
+            output << "\n";
+        }
+
+        output << theBar << theSteps.size() << " rows in set ";
+        return true;
+    }
+
+    bool StatsView::showStats(const std::string& aTableName, const TableStats& aStats) {
+        auto toString = [](const std::optional<Value>& aValue) {
+            std::ostringstream theText;
+            if (aValue)
+                theText << *aValue;
+            else
+                theText << "NULL";
+            return theText.str();
+        };
+
+        //the text of each line first, the widths follow the longest cell
+        std::vector<StringList> theLines;
+        std::vector<size_t> theWidths{ 7, 6, 9, 4, 4, 10 };
+        for (auto& column : aStats.columns) {
+            const ColumnStats& theStats = column.second;
+            std::string theBounds;
+            for (auto& bound : theStats.histogram)
+                theBounds += (theBounds.size() ? ", " : "") + toString(bound);
+            theLines.push_back({ column.first, std::to_string(theStats.nulls),
+                theStats.distinct ? std::to_string(theStats.distinct) : "?",
+                toString(theStats.min), toString(theStats.max), theBounds });
+            for (size_t i = 0; i < theWidths.size(); ++i)
+                theWidths[i] = std::max(theWidths[i], theLines.back()[i].size() + 1);
+        }
+
+        std::string theBar = "+";
+        for (auto theWidth : theWidths)
+            theBar += std::string(theWidth + 1, '-') + "+";
+        theBar += "\n";
+
+        output << aTableName << ": " << aStats.rows << " rows\n" << theBar;
+        StringList theTitles{ "column", "nulls", "distinct", "min", "max", "histogram" };
+        output << "|";
+        for (size_t i = 0; i < theTitles.size(); ++i)
+            output << " " << std::setw(theWidths[i]) << std::left << theTitles[i] << "|";
+        output << "\n" << theBar;
+
+        for (auto& line : theLines) {
+            output << "|";
+            for (size_t i = 0; i < line.size(); ++i)
+                output << " " << std::setw(theWidths[i]) << std::left << line[i] << "|";
+            output << "\n";
+        }
+
+        output << theBar << theLines.size() << " rows in set ";
+        return true;
+    }
+
     bool DebugView::debugDump(std::unique_ptr<std::vector<BlockHeader>>& aHeaders) {
         static std::unordered_map< BlockType, std::string> blockTypeToString {
             {BlockType::meta_block, "meta"},
@@ -354,6 +425,7 @@ namespace ECE141 {
             {BlockType::entity_block, "entity"},
             {BlockType::free_block, "free"},
             {BlockType::index_block, "index"},
+            {BlockType::stats_block, "stats"},
             {BlockType::unknown_block, "unknown"}
         };
 
@@ -388,6 +460,7 @@ namespace ECE141 {
                     << "| " << std::setw(14) << std::left << "";
                 break;
             case((int)BlockType::index_block):
+            case((int)BlockType::stats_block):
                 output << cur.refId
                     << "| " << std::setw(14) << std::left << "";
                 break;
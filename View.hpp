@@ -18,6 +18,8 @@
 #include "Row.hpp"
 #include "Entity.hpp"
 #include "Query.hpp"
+#include "Plan.hpp"
+#include "Statistics.hpp"
 
 
 namespace ECE141 {
@@ -91,6 +93,22 @@ namespace ECE141 {
       void showPairs(IndexPairs& anIndexes, bool all = false);
   };
   
+  class PlanView : public View {
+  public:
+      PlanView(std::ostream& anOutput) : View(anOutput) {}
+      ~PlanView() {}
+      //one line per operator, with the measurements of explain analyze
+      bool showPlan(const QueryPlan& aPlan);
+  };
+
+  class StatsView : public View {
+  public:
+      StatsView(std::ostream& anOutput) : View(anOutput) {}
+      ~StatsView() {}
+      //one line per column: nulls, distinct values, range and histogram bounds
+      bool showStats(const std::string& aTableName, const TableStats& aStats);
+  };
+
   class DebugView : public View {
   public:
       DebugView(std::ostream& anOutput) : View(anOutput) {}
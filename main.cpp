@@ -26,19 +26,37 @@ int main(int argc, const char * argv[]) {
   if(argc>1) {
     ECE141::TestAutomatic theTests;
     std::map<std::string, std::function<bool()> > theCalls {
+      {"Aggregate",[&](){return theTests.doAggregateTest();}},
       {"Alter",  [&](){return theTests.doAlterTest();}},
       {"App",    [&](){return theTests.doAppTest();}},
       {"Cache",  [&](){return theTests.doCacheTest();}},
+      {"BulkDelete",[&](){return theTests.doBulkDeleteTest();}},
+      {"BulkInsert",[&](){return theTests.doBulkInsertTest();}},
+      {"Copy",[&](){return theTests.doCopyTest();}},
+      {"Load",[&](){return theTests.doLoadTest();}},
+      {"Mutate",[&](){return theTests.doMutateTest();}},
+      {"Projection",[&](){return theTests.doProjectionTest();}},
+      {"Rewrite",[&](){return theTests.doRewriteTest();}},
       {"Compile",[&](){return theTests.doCompileTest();}},
       {"DB",     [&](){return theTests.doDBTest();}},
       {"Delete", [&](){return theTests.doDeleteTest();}},
+      {"Distinct",[&](){return theTests.doDistinctTest();}},
+      {"Explain",[&](){return theTests.doExplainTest();}},
+      {"Scan",[&](){return theTests.doScanTest();}},
       {"Drop",   [&](){return theTests.doDropTest();}},
       {"Index",  [&](){return theTests.doIndexTest();}},
       {"Insert", [&](){return theTests.doInsertTest();}},
       {"Join",   [&](){return theTests.doJoinTest();}},
+      {"Limit",  [&](){return theTests.doLimitTest();}},
+      {"OrderBy",[&](){return theTests.doOrderByTest();}},
+      {"Schema", [&](){return theTests.doSchemaTest();}},
       {"Select", [&](){return theTests.doSelectTest();}},
+      {"Stats",  [&](){return theTests.doStatsTest();}},
       {"Tables", [&](){return theTests.doTablesTest();}},
+      {"Truncate",[&](){return theTests.doTruncateTest();}},
       {"Update", [&](){return theTests.doUpdateTest();}},
+      {"Upsert", [&](){return theTests.doUpsertTest();}},
+      {"Vacuum", [&](){return theTests.doVacuumTest();}},
     };
     
     std::string theCmd(argv[1]);